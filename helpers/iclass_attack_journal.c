@@ -0,0 +1,138 @@
+#include "iclass_attack_journal.h"
+
+#include <furi/furi.h>
+#include <storage/storage.h>
+#include <lib/toolbox/stream/file_stream.h>
+
+#define TAG "IclassAttackJournal"
+
+#define ICLASS_ATTACK_JOURNAL_DIR APP_DATA_PATH("journal")
+
+#define ICLASS_ATTACK_JOURNAL_MAGIC     "PPJOURNL"
+#define ICLASS_ATTACK_JOURNAL_MAGIC_LEN (8)
+#define ICLASS_ATTACK_JOURNAL_VERSION   (6)
+#define ICLASS_ATTACK_JOURNAL_CSN_LEN   (8)
+
+// The state is stored as is, size catches a journal written by a build with another layout
+typedef struct __attribute__((packed)) {
+    char magic[ICLASS_ATTACK_JOURNAL_MAGIC_LEN];
+    uint16_t version;
+    uint16_t state_size;
+    uint8_t csn[ICLASS_ATTACK_JOURNAL_CSN_LEN];
+} IclassAttackJournalHeader;
+
+static FuriString* iclass_attack_journal_path(const char* attack, const uint8_t* csn) {
+    FuriString* path = furi_string_alloc_printf("%s/", ICLASS_ATTACK_JOURNAL_DIR);
+    for(size_t i = 0; i < ICLASS_ATTACK_JOURNAL_CSN_LEN; i++) {
+        furi_string_cat_printf(path, "%02X", csn[i]);
+    }
+    furi_string_cat_printf(path, "_%s.bin", attack);
+    return path;
+}
+
+bool iclass_attack_journal_load(const char* attack, const uint8_t* csn, IclassKeyIter* iter) {
+    furi_assert(attack);
+    furi_assert(csn);
+    furi_assert(iter);
+
+    FuriString* path = iclass_attack_journal_path(attack, csn);
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    Stream* stream = file_stream_alloc(storage);
+    IclassKeyIterState* state = malloc(sizeof(IclassKeyIterState));
+
+    bool loaded = false;
+    do {
+        if(!file_stream_open(
+               stream, furi_string_get_cstr(path), FSAM_READ, FSOM_OPEN_EXISTING)) {
+            break;
+        }
+
+        IclassAttackJournalHeader header = {};
+        if(stream_read(stream, (uint8_t*)&header, sizeof(header)) != sizeof(header)) break;
+        bool header_valid =
+            memcmp(header.magic, ICLASS_ATTACK_JOURNAL_MAGIC, ICLASS_ATTACK_JOURNAL_MAGIC_LEN) ==
+                0 &&
+            header.version == ICLASS_ATTACK_JOURNAL_VERSION &&
+            header.state_size == sizeof(IclassKeyIterState) &&
+            memcmp(header.csn, csn, ICLASS_ATTACK_JOURNAL_CSN_LEN) == 0;
+        if(!header_valid) break;
+        if(stream_read(stream, (uint8_t*)state, sizeof(IclassKeyIterState)) !=
+           sizeof(IclassKeyIterState)) {
+            break;
+        }
+
+        loaded = iclass_key_iter_set_state(iter, state);
+    } while(false);
+
+    if(loaded) {
+        FURI_LOG_I(
+            TAG,
+            "Resuming %s at source %u key %lu",
+            furi_string_get_cstr(path),
+            state->source_index,
+            state->source_position);
+    }
+
+    free(state);
+    file_stream_close(stream);
+    stream_free(stream);
+    furi_record_close(RECORD_STORAGE);
+    furi_string_free(path);
+
+    return loaded;
+}
+
+bool iclass_attack_journal_save(const char* attack, const uint8_t* csn, IclassKeyIter* iter) {
+    furi_assert(attack);
+    furi_assert(csn);
+    furi_assert(iter);
+
+    FuriString* path = iclass_attack_journal_path(attack, csn);
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    Stream* stream = file_stream_alloc(storage);
+    IclassKeyIterState* state = malloc(sizeof(IclassKeyIterState));
+    iclass_key_iter_get_state(iter, state);
+
+    IclassAttackJournalHeader header = {
+        .version = ICLASS_ATTACK_JOURNAL_VERSION,
+        .state_size = sizeof(IclassKeyIterState),
+    };
+    memcpy(header.magic, ICLASS_ATTACK_JOURNAL_MAGIC, ICLASS_ATTACK_JOURNAL_MAGIC_LEN);
+    memcpy(header.csn, csn, ICLASS_ATTACK_JOURNAL_CSN_LEN);
+
+    bool saved = false;
+    do {
+        storage_simply_mkdir(storage, ICLASS_ATTACK_JOURNAL_DIR);
+        if(!file_stream_open(
+               stream, furi_string_get_cstr(path), FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+            break;
+        }
+        if(stream_write(stream, (uint8_t*)&header, sizeof(header)) != sizeof(header)) break;
+        if(stream_write(stream, (uint8_t*)state, sizeof(IclassKeyIterState)) !=
+           sizeof(IclassKeyIterState)) {
+            break;
+        }
+        saved = true;
+    } while(false);
+
+    if(!saved) FURI_LOG_E(TAG, "Failed to save %s", furi_string_get_cstr(path));
+
+    free(state);
+    file_stream_close(stream);
+    stream_free(stream);
+    furi_record_close(RECORD_STORAGE);
+    furi_string_free(path);
+
+    return saved;
+}
+
+void iclass_attack_journal_remove(const char* attack, const uint8_t* csn) {
+    furi_assert(attack);
+    furi_assert(csn);
+
+    FuriString* path = iclass_attack_journal_path(attack, csn);
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    storage_simply_remove(storage, furi_string_get_cstr(path));
+    furi_record_close(RECORD_STORAGE);
+    furi_string_free(path);
+}
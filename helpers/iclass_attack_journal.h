@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "iclass_key_iter.h"
+
+/**
+ * Where a key attack on a card stopped, one file per CSN and attack so presenting the card again
+ * picks up from there instead of the first key.
+ */
+
+/**
+ * Restores iter for csn, false (and iter untouched) if there is no usable journal
+ */
+bool iclass_attack_journal_load(const char* attack, const uint8_t* csn, IclassKeyIter* iter);
+
+bool iclass_attack_journal_save(const char* attack, const uint8_t* csn, IclassKeyIter* iter);
+
+/**
+ * Forgets csn once the attack found the key or ran out of keys
+ */
+void iclass_attack_journal_remove(const char* attack, const uint8_t* csn);
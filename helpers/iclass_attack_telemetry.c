@@ -0,0 +1,145 @@
+#include "iclass_attack_telemetry.h"
+
+#include <furi/furi.h>
+#include <furi_hal.h>
+#include <storage/storage.h>
+#include <toolbox/version.h>
+#include <lib/toolbox/stream/file_stream.h>
+
+#define TAG "IclassAttackTelemetry"
+
+#define ICLASS_ATTACK_TELEMETRY_LOG APP_DATA_PATH("attack_telemetry.log")
+
+// Updates closer together than this are folded into the next one, a few keys are too noisy
+#define ICLASS_ATTACK_TELEMETRY_SAMPLE_MS (500)
+// Weight of the newest sample, about the last 4 s at the usual update rate
+#define ICLASS_ATTACK_TELEMETRY_SMOOTHING (0.25f)
+
+static uint32_t iclass_attack_telemetry_cycles_to_ms(uint64_t cycles) {
+    return cycles / (furi_hal_cortex_instructions_per_microsecond() * 1000);
+}
+
+void iclass_attack_telemetry_start(IclassAttackTelemetry* telemetry) {
+    furi_assert(telemetry);
+
+    memset(telemetry, 0, sizeof(IclassAttackTelemetry));
+    telemetry->start_tick = furi_get_tick();
+    telemetry->sample_tick = telemetry->start_tick;
+}
+
+void iclass_attack_telemetry_update(IclassAttackTelemetry* telemetry, PicopassPoller* poller) {
+    furi_assert(telemetry);
+    furi_assert(poller);
+
+    picopass_poller_get_stats(poller, &telemetry->stats);
+
+    uint32_t now = furi_get_tick();
+    uint32_t elapsed_ms = now - telemetry->sample_tick;
+    if(elapsed_ms < ICLASS_ATTACK_TELEMETRY_SAMPLE_MS) return;
+
+    float keys_per_s =
+        (float)(telemetry->stats.keys_tried - telemetry->sample_keys) * 1000.0f / elapsed_ms;
+    if(telemetry->keys_per_s == 0.0f) {
+        telemetry->keys_per_s = keys_per_s;
+    } else {
+        telemetry->keys_per_s +=
+            (keys_per_s - telemetry->keys_per_s) * ICLASS_ATTACK_TELEMETRY_SMOOTHING;
+    }
+    telemetry->sample_tick = now;
+    telemetry->sample_keys = telemetry->stats.keys_tried;
+}
+
+uint32_t iclass_attack_telemetry_get_keys_per_s(IclassAttackTelemetry* telemetry) {
+    furi_assert(telemetry);
+
+    return telemetry->keys_per_s + 0.5f;
+}
+
+uint32_t iclass_attack_telemetry_get_eta(IclassAttackTelemetry* telemetry, uint32_t keys_left) {
+    furi_assert(telemetry);
+
+    if(telemetry->keys_per_s < 0.1f) return 0;
+    return keys_left / telemetry->keys_per_s + 0.5f;
+}
+
+uint8_t iclass_attack_telemetry_get_rf_percent(IclassAttackTelemetry* telemetry) {
+    furi_assert(telemetry);
+
+    const PicopassPollerStats* stats = &telemetry->stats;
+    uint64_t cpu_cycles = stats->div_key_cycles + stats->mac_cycles + stats->prefetch_wait_cycles;
+    uint64_t total_cycles = stats->rf_cycles + cpu_cycles;
+    if(total_cycles == 0) return 0;
+    return stats->rf_cycles * 100 / total_cycles;
+}
+
+bool iclass_attack_telemetry_log(
+    IclassAttackTelemetry* telemetry,
+    const char* attack,
+    const char* result) {
+    furi_assert(telemetry);
+    furi_assert(attack);
+    furi_assert(result);
+
+    const PicopassPollerStats* stats = &telemetry->stats;
+    uint32_t duration_ms = furi_get_tick() - telemetry->start_tick;
+    uint32_t keys_per_100s =
+        duration_ms == 0 ? 0 : (uint64_t)stats->keys_tried * 100000 / duration_ms;
+    DateTime datetime;
+    furi_hal_rtc_get_datetime(&datetime);
+    const Version* version = version_get();
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    Stream* stream = file_stream_alloc(storage);
+
+    bool logged = false;
+    do {
+        if(!file_stream_open(stream, ICLASS_ATTACK_TELEMETRY_LOG, FSAM_WRITE, FSOM_OPEN_APPEND)) {
+            break;
+        }
+        // One line per run: when, what, where, then the numbers to compare
+        stream_write_format(
+            stream,
+            "%04d-%02d-%02d %02d:%02d:%02d %s %s fw %s %s app %s",
+            datetime.year,
+            datetime.month,
+            datetime.day,
+            datetime.hour,
+            datetime.minute,
+            datetime.second,
+            attack,
+            result,
+            version_get_firmware_origin(version),
+            version_get_version(version),
+            FAP_VERSION);
+        stream_write_format(
+            stream,
+            " keys %lu time %lu ms rate %lu.%02lu/s",
+            stats->keys_tried,
+            duration_ms,
+            keys_per_100s / 100,
+            keys_per_100s % 100);
+        stream_write_format(
+            stream,
+            " rf %lu ms div %lu ms mac %lu ms wait %lu ms precomputed %lu computed %lu",
+            iclass_attack_telemetry_cycles_to_ms(stats->rf_cycles),
+            iclass_attack_telemetry_cycles_to_ms(stats->div_key_cycles),
+            iclass_attack_telemetry_cycles_to_ms(stats->mac_cycles),
+            iclass_attack_telemetry_cycles_to_ms(stats->prefetch_wait_cycles),
+            stats->mac_precomputed,
+            stats->mac_computed);
+        stream_write_format(
+            stream,
+            " detect p50 %lu ms p90 %lu ms\n",
+            picopass_poller_stats_get_detect_latency(stats, 50),
+            picopass_poller_stats_get_detect_latency(stats, 90));
+        logged = true;
+    } while(false);
+
+    if(!logged) FURI_LOG_E(TAG, "Failed to append to %s", ICLASS_ATTACK_TELEMETRY_LOG);
+
+    file_stream_close(stream);
+    stream_free(stream);
+    furi_record_close(RECORD_STORAGE);
+
+    return logged;
+}
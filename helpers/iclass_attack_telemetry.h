@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../protocol/picopass_poller.h"
+
+/**
+ * Rolling attack speed for the view, and a per-run line in a log so runs on different
+ * firmwares, cards and dictionaries can be compared.
+ */
+
+typedef struct {
+    uint32_t start_tick;
+    uint32_t sample_tick;
+    uint32_t sample_keys;
+    float keys_per_s;
+    PicopassPollerStats stats;
+} IclassAttackTelemetry;
+
+void iclass_attack_telemetry_start(IclassAttackTelemetry* telemetry);
+
+/**
+ * Takes a stats snapshot, call it from the poller thread so the counters are not torn
+ */
+void iclass_attack_telemetry_update(IclassAttackTelemetry* telemetry, PicopassPoller* poller);
+
+uint32_t iclass_attack_telemetry_get_keys_per_s(IclassAttackTelemetry* telemetry);
+
+/**
+ * Seconds until keys_left keys are tried at the rolling rate, 0 if not known yet
+ */
+uint32_t iclass_attack_telemetry_get_eta(IclassAttackTelemetry* telemetry, uint32_t keys_left);
+
+/**
+ * Share of the authentication time spent on air rather than in crypto
+ */
+uint8_t iclass_attack_telemetry_get_rf_percent(IclassAttackTelemetry* telemetry);
+
+bool iclass_attack_telemetry_log(
+    IclassAttackTelemetry* telemetry,
+    const char* attack,
+    const char* result);
@@ -0,0 +1,130 @@
+#include "iclass_div_table.h"
+
+#include <furi/furi.h>
+#include <storage/storage.h>
+#include <lib/toolbox/stream/file_stream.h>
+
+#define TAG "IclassDivTable"
+
+#define ICLASS_DIV_TABLE_MAGIC     "PICODIVT"
+#define ICLASS_DIV_TABLE_MAGIC_LEN (8)
+#define ICLASS_DIV_TABLE_VERSION   (1)
+#define ICLASS_DIV_TABLE_KEY_LEN   (8)
+
+// Same layout as tools/iclass_div_table.c writes, entries sorted by key
+typedef struct __attribute__((packed)) {
+    char magic[ICLASS_DIV_TABLE_MAGIC_LEN];
+    uint16_t version;
+    uint16_t key_len;
+    uint8_t csn[ICLASS_DIV_TABLE_KEY_LEN];
+    uint32_t total_keys;
+} IclassDivTableHeader;
+
+typedef struct {
+    uint8_t key[ICLASS_DIV_TABLE_KEY_LEN];
+    uint8_t div_key[ICLASS_DIV_TABLE_KEY_LEN];
+} IclassDivTableEntry;
+
+struct IclassDivTable {
+    uint8_t csn[ICLASS_DIV_TABLE_KEY_LEN];
+    size_t count;
+    IclassDivTableEntry entries[];
+};
+
+static FuriString* iclass_div_table_path(const uint8_t* csn) {
+    FuriString* path = furi_string_alloc_printf("%s/", ICLASS_DIV_TABLE_DIR);
+    for(size_t i = 0; i < ICLASS_DIV_TABLE_KEY_LEN; i++) {
+        furi_string_cat_printf(path, "%02X", csn[i]);
+    }
+    furi_string_cat_printf(path, ".bin");
+    return path;
+}
+
+IclassDivTable* iclass_div_table_alloc(const uint8_t* csn) {
+    furi_assert(csn);
+
+    FuriString* path = iclass_div_table_path(csn);
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    Stream* stream = file_stream_alloc(storage);
+
+    IclassDivTable* table = NULL;
+    do {
+        if(!file_stream_open(
+               stream, furi_string_get_cstr(path), FSAM_READ, FSOM_OPEN_EXISTING)) {
+            break;
+        }
+
+        IclassDivTableHeader header = {};
+        if(stream_read(stream, (uint8_t*)&header, sizeof(header)) != sizeof(header)) break;
+        bool header_valid =
+            memcmp(header.magic, ICLASS_DIV_TABLE_MAGIC, ICLASS_DIV_TABLE_MAGIC_LEN) == 0 &&
+            header.version == ICLASS_DIV_TABLE_VERSION &&
+            header.key_len == ICLASS_DIV_TABLE_KEY_LEN &&
+            memcmp(header.csn, csn, ICLASS_DIV_TABLE_KEY_LEN) == 0 &&
+            header.total_keys <= ICLASS_DIV_TABLE_MAX_KEYS;
+        if(!header_valid) {
+            FURI_LOG_W(TAG, "Ignoring %s", furi_string_get_cstr(path));
+            break;
+        }
+
+        size_t entries_size = header.total_keys * sizeof(IclassDivTableEntry);
+        table = malloc(sizeof(IclassDivTable) + entries_size);
+        memcpy(table->csn, csn, ICLASS_DIV_TABLE_KEY_LEN);
+        table->count = header.total_keys;
+        if(stream_read(stream, (uint8_t*)table->entries, entries_size) != entries_size) {
+            free(table);
+            table = NULL;
+            break;
+        }
+        FURI_LOG_I(TAG, "Loaded %zu div keys from %s", table->count, furi_string_get_cstr(path));
+    } while(false);
+
+    file_stream_close(stream);
+    stream_free(stream);
+    furi_record_close(RECORD_STORAGE);
+    furi_string_free(path);
+
+    return table;
+}
+
+void iclass_div_table_free(IclassDivTable* table) {
+    furi_assert(table);
+
+    free(table);
+}
+
+size_t iclass_div_table_get_count(IclassDivTable* table) {
+    furi_assert(table);
+
+    return table->count;
+}
+
+bool iclass_div_table_lookup(
+    IclassDivTable* table,
+    const uint8_t* csn,
+    const uint8_t* key,
+    uint8_t* div_key) {
+    furi_assert(table);
+    furi_assert(csn);
+    furi_assert(key);
+    furi_assert(div_key);
+
+    if(memcmp(table->csn, csn, ICLASS_DIV_TABLE_KEY_LEN) != 0) return false;
+
+    size_t low = 0;
+    size_t high = table->count;
+    while(low < high) {
+        size_t mid = low + (high - low) / 2;
+        int cmp = memcmp(table->entries[mid].key, key, ICLASS_DIV_TABLE_KEY_LEN);
+        if(cmp == 0) {
+            memcpy(div_key, table->entries[mid].div_key, ICLASS_DIV_TABLE_KEY_LEN);
+            return true;
+        } else if(cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return false;
+}
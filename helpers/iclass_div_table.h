@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Standard KDF keys diversified ahead of time for one CSN by tools/iclass_div_table.c, so a
+ * card that comes back skips DES for every dictionary key in the table.
+ */
+
+#define ICLASS_DIV_TABLE_DIR      APP_DATA_PATH("div")
+#define ICLASS_DIV_TABLE_MAX_KEYS (512)
+
+typedef struct IclassDivTable IclassDivTable;
+
+/**
+ * Loads the table for csn, NULL when there is none or it does not belong to csn
+ */
+IclassDivTable* iclass_div_table_alloc(const uint8_t* csn);
+
+void iclass_div_table_free(IclassDivTable* table);
+
+size_t iclass_div_table_get_count(IclassDivTable* table);
+
+/**
+ * Standard KDF div key of key for csn, false if the table has no such pair
+ */
+bool iclass_div_table_lookup(
+    IclassDivTable* table,
+    const uint8_t* csn,
+    const uint8_t* key,
+    uint8_t* div_key);
@@ -7,21 +7,76 @@
 #define ICLASS_STANDARD_DICT_FLIPPER_NAME APP_ASSETS_PATH("iclass_standard_dict.txt")
 #define ICLASS_ELITE_DICT_USER_NAME       APP_DATA_PATH("assets/iclass_elite_dict_user.txt")
 
+// Compiled from the .txt dictionaries at build time by tools/iclass_dict_compile.py
+#define ICLASS_ELITE_DICT_FLIPPER_BIN_NAME    APP_ASSETS_PATH("iclass_elite_dict.bin")
+#define ICLASS_STANDARD_DICT_FLIPPER_BIN_NAME APP_ASSETS_PATH("iclass_standard_dict.bin")
+
 #define TAG "IclassEliteDict"
 
-#define ICLASS_ELITE_KEY_LINE_LEN (17)
-#define ICLASS_ELITE_KEY_LEN      (8)
+#define ICLASS_ELITE_KEY_LEN (8)
+
+#define ICLASS_ELITE_DICT_BIN_MAGIC     "PICODICT"
+#define ICLASS_ELITE_DICT_BIN_MAGIC_LEN (8)
+#define ICLASS_ELITE_DICT_BIN_VERSION   (1)
+#define ICLASS_ELITE_DICT_BLOCK_KEYS    (32)
+
+typedef struct __attribute__((packed)) {
+    char magic[ICLASS_ELITE_DICT_BIN_MAGIC_LEN];
+    uint16_t version;
+    uint16_t key_len;
+    uint32_t total_keys;
+} IclassEliteDictBinHeader;
 
 struct IclassEliteDict {
     Stream* stream;
+    bool compiled;
     uint32_t total_keys;
+
+    // Text dictionaries
+    FuriString* next_line;
+
+    // Compiled dictionaries: keys are read a block at a time and served with memcpy
+    uint32_t next_key;
+    uint32_t block_start;
+    uint32_t block_keys;
+    uint8_t block[ICLASS_ELITE_DICT_BLOCK_KEYS * ICLASS_ELITE_KEY_LEN];
 };
 
+static const char* iclass_elite_dict_get_bin_name(IclassEliteDictType dict_type) {
+    if(dict_type == IclassEliteDictTypeFlipper) {
+        return ICLASS_ELITE_DICT_FLIPPER_BIN_NAME;
+    } else if(dict_type == IclassStandardDictTypeFlipper) {
+        return ICLASS_STANDARD_DICT_FLIPPER_BIN_NAME;
+    }
+    return NULL;
+}
+
+// The line rule tools/iclass_dict_compile.py follows too, so a dictionary holds the same keys
+// compiled or not: LF or CRLF endings, comments and anything but 16 hex digits skipped
+static bool iclass_elite_dict_parse_line(FuriString* line, uint8_t* key) {
+    size_t len = furi_string_size(line);
+    while(len > 0 && (furi_string_get_char(line, len - 1) == '\n' ||
+                      furi_string_get_char(line, len - 1) == '\r')) {
+        len--;
+    }
+    if(len != ICLASS_ELITE_KEY_LEN * 2 || furi_string_get_char(line, 0) == '#') return false;
+
+    for(size_t i = 0; i < ICLASS_ELITE_KEY_LEN; i++) {
+        char hi = furi_string_get_char(line, i * 2);
+        char lo = furi_string_get_char(line, i * 2 + 1);
+        if(!args_char_to_hex(hi, lo, &key[i])) return false;
+    }
+    return true;
+}
+
 bool iclass_elite_dict_check_presence(IclassEliteDictType dict_type) {
     Storage* storage = furi_record_open(RECORD_STORAGE);
 
     bool dict_present = false;
-    if(dict_type == IclassEliteDictTypeFlipper) {
+    const char* bin_name = iclass_elite_dict_get_bin_name(dict_type);
+    if(bin_name && storage_common_stat(storage, bin_name, NULL) == FSE_OK) {
+        dict_present = true;
+    } else if(dict_type == IclassEliteDictTypeFlipper) {
         dict_present =
             (storage_common_stat(storage, ICLASS_ELITE_DICT_FLIPPER_NAME, NULL) == FSE_OK);
     } else if(dict_type == IclassEliteDictTypeUser) {
@@ -36,11 +91,61 @@ bool iclass_elite_dict_check_presence(IclassEliteDictType dict_type) {
     return dict_present;
 }
 
+static bool
+    iclass_elite_dict_open_compiled(IclassEliteDict* dict, Storage* storage, const char* path) {
+    bool dict_loaded = false;
+    dict->stream = file_stream_alloc(storage);
+
+    do {
+        if(!file_stream_open(dict->stream, path, FSAM_READ, FSOM_OPEN_EXISTING)) break;
+
+        IclassEliteDictBinHeader header = {};
+        if(stream_read(dict->stream, (uint8_t*)&header, sizeof(header)) != sizeof(header)) break;
+        bool header_valid =
+            memcmp(header.magic, ICLASS_ELITE_DICT_BIN_MAGIC, ICLASS_ELITE_DICT_BIN_MAGIC_LEN) ==
+                0 &&
+            header.version == ICLASS_ELITE_DICT_BIN_VERSION &&
+            header.key_len == ICLASS_ELITE_KEY_LEN;
+        if(!header_valid) {
+            FURI_LOG_W(TAG, "Unsupported compiled dictionary %s", path);
+            break;
+        }
+        size_t expected_size = sizeof(header) + header.total_keys * ICLASS_ELITE_KEY_LEN;
+        if(stream_size(dict->stream) != expected_size) {
+            FURI_LOG_W(TAG, "Truncated compiled dictionary %s", path);
+            break;
+        }
+
+        dict->compiled = true;
+        dict->total_keys = header.total_keys;
+        dict_loaded = true;
+    } while(false);
+
+    if(!dict_loaded) {
+        file_stream_close(dict->stream);
+        stream_free(dict->stream);
+        dict->stream = NULL;
+    }
+
+    return dict_loaded;
+}
+
 IclassEliteDict* iclass_elite_dict_alloc(IclassEliteDictType dict_type) {
     IclassEliteDict* dict = malloc(sizeof(IclassEliteDict));
     Storage* storage = furi_record_open(RECORD_STORAGE);
+
+    // Prefer the compiled dictionary, the key count comes from its header and keys need no
+    // parsing. The .txt is still used when the .bin is missing or out of date.
+    const char* bin_name = iclass_elite_dict_get_bin_name(dict_type);
+    if(bin_name && storage_common_stat(storage, bin_name, NULL) == FSE_OK &&
+       iclass_elite_dict_open_compiled(dict, storage, bin_name)) {
+        FURI_LOG_I(TAG, "Loaded compiled dictionary with %lu keys", dict->total_keys);
+        furi_record_close(RECORD_STORAGE);
+        return dict;
+    }
+
     dict->stream = buffered_file_stream_alloc(storage);
-    FuriString* next_line = furi_string_alloc();
+    dict->next_line = furi_string_alloc();
 
     bool dict_loaded = false;
     do {
@@ -68,13 +173,13 @@ IclassEliteDict* iclass_elite_dict_alloc(IclassEliteDictType dict_type) {
         }
 
         // Read total amount of keys
+        uint8_t key[ICLASS_ELITE_KEY_LEN];
         while(true) { //-V547
-            if(!stream_read_line(dict->stream, next_line)) break;
-            if(furi_string_get_char(next_line, 0) == '#') continue;
-            if(furi_string_size(next_line) != ICLASS_ELITE_KEY_LINE_LEN) continue;
+            if(!stream_read_line(dict->stream, dict->next_line)) break;
+            if(!iclass_elite_dict_parse_line(dict->next_line, key)) continue;
             dict->total_keys++;
         }
-        furi_string_reset(next_line);
+        furi_string_reset(dict->next_line);
         stream_rewind(dict->stream);
 
         dict_loaded = true;
@@ -83,12 +188,13 @@ IclassEliteDict* iclass_elite_dict_alloc(IclassEliteDictType dict_type) {
 
     if(!dict_loaded) { //-V547
         buffered_file_stream_close(dict->stream);
+        stream_free(dict->stream);
+        furi_string_free(dict->next_line);
         free(dict);
         dict = NULL;
     }
 
     furi_record_close(RECORD_STORAGE);
-    furi_string_free(next_line);
 
     return dict;
 }
@@ -97,7 +203,12 @@ void iclass_elite_dict_free(IclassEliteDict* dict) {
     furi_assert(dict);
     furi_assert(dict->stream);
 
-    buffered_file_stream_close(dict->stream);
+    if(dict->compiled) {
+        file_stream_close(dict->stream);
+    } else {
+        buffered_file_stream_close(dict->stream);
+        furi_string_free(dict->next_line);
+    }
     stream_free(dict->stream);
     free(dict);
 }
@@ -108,30 +219,71 @@ uint32_t iclass_elite_dict_get_total_keys(IclassEliteDict* dict) {
     return dict->total_keys;
 }
 
+static bool iclass_elite_dict_load_block(IclassEliteDict* dict, uint32_t index) {
+    uint32_t block_start = index - (index % ICLASS_ELITE_DICT_BLOCK_KEYS);
+    uint32_t block_keys =
+        MIN(dict->total_keys - block_start, (uint32_t)ICLASS_ELITE_DICT_BLOCK_KEYS);
+    size_t block_size = block_keys * ICLASS_ELITE_KEY_LEN;
+
+    dict->block_keys = 0;
+    if(!stream_seek(
+           dict->stream,
+           sizeof(IclassEliteDictBinHeader) + block_start * ICLASS_ELITE_KEY_LEN,
+           StreamOffsetFromStart)) {
+        return false;
+    }
+    if(stream_read(dict->stream, dict->block, block_size) != block_size) return false;
+
+    dict->block_start = block_start;
+    dict->block_keys = block_keys;
+    return true;
+}
+
+bool iclass_elite_dict_get_key(IclassEliteDict* dict, uint32_t index, uint8_t* key) {
+    furi_assert(dict);
+    furi_assert(dict->stream);
+
+    if(index >= dict->total_keys) return false;
+
+    if(!dict->compiled) {
+        // Text dictionaries can only be walked from the start
+        if(index < dict->next_key) {
+            iclass_elite_dict_rewind(dict);
+        }
+        while(dict->next_key <= index) {
+            if(!iclass_elite_dict_get_next_key(dict, key)) return false;
+        }
+        return true;
+    }
+
+    if(index < dict->block_start || index >= dict->block_start + dict->block_keys) {
+        if(!iclass_elite_dict_load_block(dict, index)) return false;
+    }
+    memcpy(
+        key,
+        &dict->block[(index - dict->block_start) * ICLASS_ELITE_KEY_LEN],
+        ICLASS_ELITE_KEY_LEN);
+    dict->next_key = index + 1;
+
+    return true;
+}
+
 bool iclass_elite_dict_get_next_key(IclassEliteDict* dict, uint8_t* key) {
     furi_assert(dict);
     furi_assert(dict->stream);
 
-    uint8_t key_byte_tmp = 0;
-    FuriString* next_line = furi_string_alloc();
+    if(dict->compiled) {
+        return iclass_elite_dict_get_key(dict, dict->next_key, key);
+    }
 
     bool key_read = false;
-    *key = 0ULL;
     while(!key_read) {
-        if(!stream_read_line(dict->stream, next_line)) break;
-        if(furi_string_get_char(next_line, 0) == '#') continue;
-        if(furi_string_size(next_line) != ICLASS_ELITE_KEY_LINE_LEN) continue;
-        for(uint8_t i = 0; i < ICLASS_ELITE_KEY_LEN * 2; i += 2) {
-            args_char_to_hex(
-                furi_string_get_char(next_line, i),
-                furi_string_get_char(next_line, i + 1),
-                &key_byte_tmp);
-            key[i / 2] = key_byte_tmp;
-        }
+        if(!stream_read_line(dict->stream, dict->next_line)) break;
+        if(!iclass_elite_dict_parse_line(dict->next_line, key)) continue;
+        dict->next_key++;
         key_read = true;
     }
 
-    furi_string_free(next_line);
     return key_read;
 }
 
@@ -139,6 +291,9 @@ bool iclass_elite_dict_rewind(IclassEliteDict* dict) {
     furi_assert(dict);
     furi_assert(dict->stream);
 
+    dict->next_key = 0;
+    if(dict->compiled) return true;
+
     return stream_rewind(dict->stream);
 }
 
@@ -146,6 +301,9 @@ bool iclass_elite_dict_add_key(IclassEliteDict* dict, uint8_t* key) {
     furi_assert(dict);
     furi_assert(dict->stream);
 
+    // Compiled dictionaries are build artifacts, only the user's text dictionary is written
+    if(dict->compiled) return false;
+
     FuriString* key_str = furi_string_alloc();
     for(size_t i = 0; i < ICLASS_ELITE_KEY_LEN; i++) {
         furi_string_cat_printf(key_str, "%02X", key[i]);
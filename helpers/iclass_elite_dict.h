@@ -24,6 +24,12 @@ uint32_t iclass_elite_dict_get_total_keys(IclassEliteDict* dict);
 
 bool iclass_elite_dict_get_next_key(IclassEliteDict* dict, uint8_t* key);
 
+/**
+ * Reads the key at index, constant time for compiled dictionaries. get_next_key continues
+ * after it.
+ */
+bool iclass_elite_dict_get_key(IclassEliteDict* dict, uint32_t index, uint8_t* key);
+
 bool iclass_elite_dict_rewind(IclassEliteDict* dict);
 
 bool iclass_elite_dict_add_key(IclassEliteDict* dict, uint8_t* key);
@@ -0,0 +1,150 @@
+#include "iclass_key_hits.h"
+
+#include <stdlib.h>
+#include <furi/furi.h>
+#include <storage/storage.h>
+#include <lib/toolbox/stream/file_stream.h>
+
+#define ICLASS_KEY_HITS_PATH APP_DATA_PATH("iclass_key_hits.bin")
+
+#define TAG "IclassKeyHits"
+
+#define ICLASS_KEY_HITS_KEY_LEN (8)
+
+// On-disk record, little endian
+typedef struct __attribute__((packed)) {
+    uint8_t key[ICLASS_KEY_HITS_KEY_LEN];
+    uint8_t elite;
+    uint8_t reserved;
+    uint16_t age;
+    uint32_t hits;
+} IclassKeyHitsRecord;
+
+struct IclassKeyHits {
+    IclassKeyHit entries[ICLASS_KEY_HITS_MAX];
+    size_t count;
+};
+
+static int iclass_key_hits_compare(const void* a, const void* b) {
+    const IclassKeyHit* hit_a = a;
+    const IclassKeyHit* hit_b = b;
+
+    if(hit_a->hits > hit_b->hits) return -1;
+    if(hit_a->hits < hit_b->hits) return 1;
+    return 0;
+}
+
+static void iclass_key_hits_load(IclassKeyHits* hits, Storage* storage) {
+    Stream* stream = file_stream_alloc(storage);
+
+    if(file_stream_open(stream, ICLASS_KEY_HITS_PATH, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        IclassKeyHitsRecord record;
+        while(hits->count < ICLASS_KEY_HITS_MAX &&
+              stream_read(stream, (uint8_t*)&record, sizeof(record)) == sizeof(record)) {
+            IclassKeyHit* hit = &hits->entries[hits->count++];
+            memcpy(hit->key, record.key, ICLASS_KEY_HITS_KEY_LEN);
+            hit->elite = record.elite;
+            hit->hits = record.hits;
+            hit->age = record.age;
+        }
+    }
+    file_stream_close(stream);
+    stream_free(stream);
+
+    qsort(hits->entries, hits->count, sizeof(IclassKeyHit), iclass_key_hits_compare);
+}
+
+static bool iclass_key_hits_save(IclassKeyHits* hits, Storage* storage) {
+    Stream* stream = file_stream_alloc(storage);
+
+    bool saved = false;
+    do {
+        if(!file_stream_open(stream, ICLASS_KEY_HITS_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS)) break;
+
+        size_t i = 0;
+        for(; i < hits->count; i++) {
+            IclassKeyHitsRecord record = {
+                .elite = hits->entries[i].elite,
+                .hits = hits->entries[i].hits,
+                .age = hits->entries[i].age,
+            };
+            memcpy(record.key, hits->entries[i].key, ICLASS_KEY_HITS_KEY_LEN);
+            if(stream_write(stream, (uint8_t*)&record, sizeof(record)) != sizeof(record)) break;
+        }
+        saved = (i == hits->count);
+    } while(false);
+
+    file_stream_close(stream);
+    stream_free(stream);
+
+    return saved;
+}
+
+IclassKeyHits* iclass_key_hits_alloc(void) {
+    IclassKeyHits* hits = malloc(sizeof(IclassKeyHits));
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    iclass_key_hits_load(hits, storage);
+    furi_record_close(RECORD_STORAGE);
+
+    FURI_LOG_D(TAG, "Loaded %zu keys with hits", hits->count);
+    return hits;
+}
+
+void iclass_key_hits_free(IclassKeyHits* hits) {
+    furi_assert(hits);
+
+    free(hits);
+}
+
+size_t iclass_key_hits_get_count(IclassKeyHits* hits) {
+    furi_assert(hits);
+
+    return hits->count;
+}
+
+const IclassKeyHit* iclass_key_hits_get(IclassKeyHits* hits, size_t index) {
+    furi_assert(hits);
+    furi_assert(index < hits->count);
+
+    return &hits->entries[index];
+}
+
+bool iclass_key_hits_record(const uint8_t* key, bool elite) {
+    furi_assert(key);
+
+    IclassKeyHits* hits = malloc(sizeof(IclassKeyHits));
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    iclass_key_hits_load(hits, storage);
+
+    IclassKeyHit* hit = NULL;
+    IclassKeyHit* oldest = NULL;
+    for(size_t i = 0; i < hits->count; i++) {
+        IclassKeyHit* entry = &hits->entries[i];
+        if(entry->elite == elite && memcmp(entry->key, key, ICLASS_KEY_HITS_KEY_LEN) == 0) {
+            hit = entry;
+        } else if(entry->age < UINT16_MAX) {
+            entry->age++;
+        }
+        // Sorted by hits, so of the oldest the one found last is also the least used
+        if(!oldest || entry->age >= oldest->age) oldest = entry;
+    }
+    if(!hit) {
+        // A new key has to open cards before it can outweigh the counts of the old ones, the
+        // key left unused for longest makes room rather than the newest one
+        hit = hits->count < ICLASS_KEY_HITS_MAX ? &hits->entries[hits->count++] : oldest;
+        memcpy(hit->key, key, ICLASS_KEY_HITS_KEY_LEN);
+        hit->elite = elite;
+        hit->hits = 0;
+    }
+    if(hit->hits < UINT32_MAX) hit->hits++;
+    hit->age = 0;
+
+    bool saved = iclass_key_hits_save(hits, storage);
+    if(!saved) FURI_LOG_E(TAG, "Failed to save %s", ICLASS_KEY_HITS_PATH);
+
+    furi_record_close(RECORD_STORAGE);
+    free(hits);
+
+    return saved;
+}
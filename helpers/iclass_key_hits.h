@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ICLASS_KEY_HITS_MAX (64)
+
+typedef struct {
+    uint8_t key[8];
+    bool elite;
+    uint32_t hits;
+    // Hits recorded for other keys since this one last opened a card
+    uint16_t age;
+} IclassKeyHit;
+
+typedef struct IclassKeyHits IclassKeyHits;
+
+/**
+ * Loads the keys that opened cards before, most hits first. Never NULL, the list is empty when
+ * nothing was recorded yet.
+ */
+IclassKeyHits* iclass_key_hits_alloc(void);
+
+void iclass_key_hits_free(IclassKeyHits* hits);
+
+size_t iclass_key_hits_get_count(IclassKeyHits* hits);
+
+const IclassKeyHit* iclass_key_hits_get(IclassKeyHits* hits, size_t index);
+
+/**
+ * Counts a successful auth with key, evicting the key unused for longest when the list is full
+ */
+bool iclass_key_hits_record(const uint8_t* key, bool elite);
@@ -0,0 +1,325 @@
+#include "iclass_key_iter.h"
+#include "iclass_elite_dict.h"
+#include "iclass_key_hits.h"
+#include "../picopass_elite_keygen.h"
+
+#include <furi/furi.h>
+
+#define TAG "IclassKeyIter"
+
+#define ICLASS_KEY_ITER_KEY_LEN (8)
+
+struct IclassKeyIter {
+    IclassKeySource sources[IclassKeySourceNum];
+    size_t num_sources;
+    size_t source_index;
+    bool source_open;
+
+    IclassEliteDict* dict;
+    IclassKeyHits* hits;
+    PicopassEliteKeygen keygen;
+    uint32_t source_total;
+    uint32_t source_position;
+    uint32_t skipped;
+
+    IclassKeyIterPair returned[ICLASS_KEY_ITER_RETURNED_MAX];
+    size_t num_returned;
+
+    // Sorted by key then elite
+    IclassKeyIterPair seen[ICLASS_KEY_ITER_SEEN_MAX];
+    size_t num_seen;
+};
+
+static bool iclass_key_iter_source_is_elite(IclassKeySource source) {
+    return source != IclassKeySourceStandardDict;
+}
+
+static void iclass_key_iter_close_source(IclassKeyIter* iter) {
+    if(iter->dict) {
+        iclass_elite_dict_free(iter->dict);
+        iter->dict = NULL;
+    }
+    if(iter->hits) {
+        iclass_key_hits_free(iter->hits);
+        iter->hits = NULL;
+    }
+    iter->source_open = false;
+}
+
+static bool iclass_key_iter_open_dict(IclassKeyIter* iter, IclassEliteDictType dict_type) {
+    if(!iclass_elite_dict_check_presence(dict_type)) return false;
+    iter->dict = iclass_elite_dict_alloc(dict_type);
+    if(!iter->dict) return false;
+    iter->source_total = iclass_elite_dict_get_total_keys(iter->dict);
+    return true;
+}
+
+static bool iclass_key_iter_open_source(IclassKeyIter* iter) {
+    IclassKeySource source = iter->sources[iter->source_index];
+    iter->source_total = 0;
+    iter->source_position = 0;
+
+    bool opened = false;
+    if(source == IclassKeySourceHits) {
+        iter->hits = iclass_key_hits_alloc();
+        iter->source_total = iclass_key_hits_get_count(iter->hits);
+        opened = true;
+    } else if(source == IclassKeySourceUserDict) {
+        opened = iclass_key_iter_open_dict(iter, IclassEliteDictTypeUser);
+    } else if(source == IclassKeySourceStandardDict) {
+        opened = iclass_key_iter_open_dict(iter, IclassStandardDictTypeFlipper);
+    } else if(source == IclassKeySourceEliteDict) {
+        opened = iclass_key_iter_open_dict(iter, IclassEliteDictTypeFlipper);
+    } else if(source == IclassKeySourceKeygen) {
+        picopass_elite_keygen_reset(&iter->keygen);
+        iter->source_total = ICLASS_KEY_ITER_KEYGEN_KEYS;
+        opened = true;
+    }
+
+    iter->source_open = opened;
+    if(opened && iter->source_total == 0) {
+        iclass_key_iter_close_source(iter);
+        opened = false;
+    }
+    return opened;
+}
+
+// Moves to the first source at or after source_index that has keys
+static bool iclass_key_iter_find_source(IclassKeyIter* iter) {
+    while(iter->source_index < iter->num_sources) {
+        if(iter->source_open || iclass_key_iter_open_source(iter)) return true;
+        iter->source_index++;
+    }
+    return false;
+}
+
+static bool iclass_key_iter_read_source(IclassKeyIter* iter, uint8_t* key) {
+    if(iter->source_position >= iter->source_total) return false;
+
+    bool key_read = true;
+    IclassKeySource source = iter->sources[iter->source_index];
+    if(source == IclassKeySourceHits) {
+        const IclassKeyHit* hit = iclass_key_hits_get(iter->hits, iter->source_position);
+        memcpy(key, hit->key, ICLASS_KEY_ITER_KEY_LEN);
+    } else if(source == IclassKeySourceKeygen) {
+        picopass_elite_keygen_next_key(&iter->keygen, key);
+    } else {
+        key_read = iclass_elite_dict_get_next_key(iter->dict, key);
+    }
+
+    if(key_read) iter->source_position++;
+    return key_read;
+}
+
+// Remembers the pair, true if it was handed out already. Once the set is full new pairs are not
+// remembered: a missed duplicate costs an RF round trip, but no candidate is ever left out
+static bool
+    iclass_key_iter_seen_test_and_add(IclassKeyIter* iter, const uint8_t* key, bool is_elite_key) {
+    IclassKeyIterPair pair = {.elite = is_elite_key};
+    memcpy(pair.key, key, ICLASS_KEY_ITER_KEY_LEN);
+
+    size_t low = 0;
+    size_t high = iter->num_seen;
+    while(low < high) {
+        size_t mid = low + (high - low) / 2;
+        int cmp = memcmp(&iter->seen[mid], &pair, sizeof(IclassKeyIterPair));
+        if(cmp == 0) return true;
+        if(cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if(iter->num_seen == ICLASS_KEY_ITER_SEEN_MAX) return false;
+    memmove(
+        &iter->seen[low + 1],
+        &iter->seen[low],
+        (iter->num_seen - low) * sizeof(IclassKeyIterPair));
+    iter->seen[low] = pair;
+    iter->num_seen++;
+    return false;
+}
+
+IclassKeyIter* iclass_key_iter_alloc(const IclassKeySource* sources, size_t num_sources) {
+    furi_assert(sources);
+    furi_assert(num_sources <= IclassKeySourceNum);
+
+    IclassKeyIter* iter = malloc(sizeof(IclassKeyIter));
+    memcpy(iter->sources, sources, num_sources * sizeof(IclassKeySource));
+    iter->num_sources = num_sources;
+    iclass_key_iter_find_source(iter);
+
+    return iter;
+}
+
+void iclass_key_iter_free(IclassKeyIter* iter) {
+    furi_assert(iter);
+
+    iclass_key_iter_close_source(iter);
+    FURI_LOG_D(TAG, "Skipped %lu duplicate keys", iter->skipped);
+    free(iter);
+}
+
+bool iclass_key_iter_next(IclassKeyIter* iter, uint8_t* key, bool* is_elite_key) {
+    furi_assert(iter);
+    furi_assert(key);
+    furi_assert(is_elite_key);
+
+    if(iter->num_returned > 0) {
+        memcpy(key, iter->returned[0].key, ICLASS_KEY_ITER_KEY_LEN);
+        *is_elite_key = iter->returned[0].elite;
+        iter->num_returned--;
+        memmove(
+            &iter->returned[0],
+            &iter->returned[1],
+            iter->num_returned * sizeof(IclassKeyIterPair));
+        return true;
+    }
+
+    while(iclass_key_iter_find_source(iter)) {
+        if(!iclass_key_iter_read_source(iter, key)) {
+            iclass_key_iter_close_source(iter);
+            iter->source_index++;
+            continue;
+        }
+
+        IclassKeySource source = iter->sources[iter->source_index];
+        *is_elite_key = source == IclassKeySourceHits ?
+                            iclass_key_hits_get(iter->hits, iter->source_position - 1)->elite :
+                            iclass_key_iter_source_is_elite(source);
+        if(iclass_key_iter_seen_test_and_add(iter, key, *is_elite_key)) {
+            iter->skipped++;
+            continue;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+bool iclass_key_iter_put_back(IclassKeyIter* iter, const uint8_t* key, bool is_elite_key) {
+    furi_assert(iter);
+    furi_assert(key);
+
+    if(iter->num_returned == ICLASS_KEY_ITER_RETURNED_MAX) {
+        FURI_LOG_W(TAG, "No room to give a key back");
+        return false;
+    }
+    IclassKeyIterPair* pair = &iter->returned[iter->num_returned++];
+    memcpy(pair->key, key, ICLASS_KEY_ITER_KEY_LEN);
+    pair->elite = is_elite_key;
+
+    return true;
+}
+
+bool iclass_key_iter_skip_source(IclassKeyIter* iter) {
+    furi_assert(iter);
+
+    if(iter->source_index >= iter->num_sources) return false;
+    iclass_key_iter_close_source(iter);
+    iter->source_index++;
+
+    return iclass_key_iter_find_source(iter);
+}
+
+bool iclass_key_iter_get_source(IclassKeyIter* iter, IclassKeySource* source) {
+    furi_assert(iter);
+
+    if(!iclass_key_iter_find_source(iter)) return false;
+    if(source) *source = iter->sources[iter->source_index];
+    return true;
+}
+
+uint32_t iclass_key_iter_get_source_total(IclassKeyIter* iter) {
+    furi_assert(iter);
+
+    return iter->source_open ? iter->source_total : 0;
+}
+
+uint32_t iclass_key_iter_get_source_position(IclassKeyIter* iter) {
+    furi_assert(iter);
+
+    return iter->source_open ? iter->source_position : 0;
+}
+
+uint32_t iclass_key_iter_get_skipped(IclassKeyIter* iter) {
+    furi_assert(iter);
+
+    return iter->skipped;
+}
+
+void iclass_key_iter_reset(IclassKeyIter* iter) {
+    furi_assert(iter);
+
+    iclass_key_iter_close_source(iter);
+    iter->source_index = 0;
+    iter->source_total = 0;
+    iter->source_position = 0;
+    iter->skipped = 0;
+    iter->num_returned = 0;
+    iter->num_seen = 0;
+}
+
+void iclass_key_iter_get_state(IclassKeyIter* iter, IclassKeyIterState* state) {
+    furi_assert(iter);
+    furi_assert(state);
+
+    memset(state, 0, sizeof(IclassKeyIterState));
+    state->num_sources = iter->num_sources;
+    for(size_t i = 0; i < iter->num_sources; i++) {
+        state->sources[i] = iter->sources[i];
+    }
+    state->source_index = iter->source_index;
+    state->source_total = iclass_key_iter_get_source_total(iter);
+    state->source_position = iclass_key_iter_get_source_position(iter);
+    state->skipped = iter->skipped;
+    state->num_returned = iter->num_returned;
+    memcpy(state->returned, iter->returned, iter->num_returned * sizeof(IclassKeyIterPair));
+}
+
+// Puts a freshly opened source at position, false if it changed since the state was saved
+static bool iclass_key_iter_seek_source(
+    IclassKeyIter* iter,
+    const IclassKeyIterState* state,
+    uint32_t position) {
+    if(iter->source_total != state->source_total || position > iter->source_total) return false;
+    if(position == 0) return true;
+
+    IclassKeySource source = iter->sources[iter->source_index];
+    if(source == IclassKeySourceKeygen) {
+        picopass_elite_keygen_seek(&iter->keygen, position);
+    } else if(source != IclassKeySourceHits) {
+        uint8_t key[ICLASS_KEY_ITER_KEY_LEN];
+        if(!iclass_elite_dict_get_key(iter->dict, position - 1, key)) return false;
+    }
+    iter->source_position = position;
+
+    return true;
+}
+
+bool iclass_key_iter_set_state(IclassKeyIter* iter, const IclassKeyIterState* state) {
+    furi_assert(iter);
+    furi_assert(state);
+
+    if(state->num_sources != iter->num_sources) return false;
+    for(size_t i = 0; i < iter->num_sources; i++) {
+        if(state->sources[i] != iter->sources[i]) return false;
+    }
+
+    iclass_key_iter_reset(iter);
+    iter->source_index = MIN((size_t)state->source_index, iter->num_sources);
+    iter->skipped = state->skipped;
+
+    if(iter->source_index < iter->num_sources && iclass_key_iter_open_source(iter) &&
+       !iclass_key_iter_seek_source(iter, state, state->source_position)) {
+        // The source changed, walk it again from its first key
+        iclass_key_iter_close_source(iter);
+        iclass_key_iter_open_source(iter);
+    }
+
+    iter->num_returned = MIN((size_t)state->num_returned, ICLASS_KEY_ITER_RETURNED_MAX);
+    memcpy(iter->returned, state->returned, iter->num_returned * sizeof(IclassKeyIterPair));
+
+    return true;
+}
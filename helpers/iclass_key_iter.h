@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum {
+    IclassKeySourceHits, // keys that opened cards before, most hits first
+    IclassKeySourceUserDict,
+    IclassKeySourceStandardDict,
+    IclassKeySourceEliteDict,
+    IclassKeySourceKeygen,
+    IclassKeySourceNum,
+} IclassKeySource;
+
+// Keys drawn from picopass_elite_keygen per attack
+#define ICLASS_KEY_ITER_KEYGEN_KEYS (2000)
+
+// Pairs remembered to skip duplicates, the bundled sources hand out about 2900
+#define ICLASS_KEY_ITER_SEEN_MAX (3072)
+
+// Keys given back unchecked: an offline batch of 32 and the two a reader can have in flight
+#define ICLASS_KEY_ITER_RETURNED_MAX (34)
+
+typedef struct IclassKeyIter IclassKeyIter;
+
+typedef struct {
+    uint8_t key[8];
+    uint8_t elite;
+} IclassKeyIterPair;
+
+/**
+ * Where an iteration stopped, small enough to save on every card change, see
+ * iclass_attack_journal. Which pairs were handed out is not part of it, so after a restore a
+ * duplicate of one handed out before the save is asked again.
+ */
+typedef struct {
+    uint8_t num_sources;
+    uint8_t sources[IclassKeySourceNum];
+    uint8_t source_index;
+    uint32_t source_total;
+    uint32_t source_position;
+    uint32_t skipped;
+    uint8_t num_returned;
+    IclassKeyIterPair returned[ICLASS_KEY_ITER_RETURNED_MAX];
+} IclassKeyIterState;
+
+/**
+ * Walks the sources in order as one stream of (key, elite) pairs. Missing or empty sources are
+ * passed over, and a pair already handed out by an earlier source is skipped without asking
+ * the card.
+ */
+IclassKeyIter* iclass_key_iter_alloc(const IclassKeySource* sources, size_t num_sources);
+
+void iclass_key_iter_free(IclassKeyIter* iter);
+
+/**
+ * Keys given back come first, in the order they were given back
+ */
+bool iclass_key_iter_next(IclassKeyIter* iter, uint8_t* key, bool* is_elite_key);
+
+/**
+ * Gives back a key that was handed out but never checked, false if there is no room for it
+ */
+bool iclass_key_iter_put_back(IclassKeyIter* iter, const uint8_t* key, bool is_elite_key);
+
+/**
+ * Abandons the current source, false if it was the last one
+ */
+bool iclass_key_iter_skip_source(IclassKeyIter* iter);
+
+/**
+ * False once every source is exhausted
+ */
+bool iclass_key_iter_get_source(IclassKeyIter* iter, IclassKeySource* source);
+
+/**
+ * Keys in the current source, and how many of them were handed out or skipped as duplicates
+ */
+uint32_t iclass_key_iter_get_source_total(IclassKeyIter* iter);
+
+uint32_t iclass_key_iter_get_source_position(IclassKeyIter* iter);
+
+/**
+ * Duplicates skipped so far, across all sources
+ */
+uint32_t iclass_key_iter_get_skipped(IclassKeyIter* iter);
+
+/**
+ * Back to the first key of the first source, forgetting which keys were handed out
+ */
+void iclass_key_iter_reset(IclassKeyIter* iter);
+
+void iclass_key_iter_get_state(IclassKeyIter* iter, IclassKeyIterState* state);
+
+/**
+ * Continues from a saved state, keys given back before the save included, with no pairs seen
+ * yet. False if the state was saved with other sources.
+ */
+bool iclass_key_iter_set_state(IclassKeyIter* iter, const IclassKeyIterState* state);
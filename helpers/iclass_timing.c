@@ -0,0 +1,139 @@
+#include "iclass_timing.h"
+
+#include <furi/furi.h>
+#include <storage/storage.h>
+#include <lib/toolbox/stream/file_stream.h>
+
+#define ICLASS_TIMING_PATH APP_DATA_PATH("iclass_timing.bin")
+
+#define TAG "IclassTiming"
+
+#define ICLASS_TIMING_CSN_LEN (8)
+
+// On-disk record, little endian, oldest first
+typedef struct __attribute__((packed)) {
+    uint8_t csn_prefix[ICLASS_TIMING_CSN_PREFIX_LEN];
+    uint32_t guard_time_us;
+    uint32_t fdt_poll_fc;
+    uint32_t fdt_poll_poll_us;
+} IclassTimingRecord;
+
+struct IclassTiming {
+    IclassTimingRecord entries[ICLASS_TIMING_MAX];
+    size_t count;
+};
+
+static const uint8_t* iclass_timing_csn_prefix(const uint8_t* csn) {
+    return csn + ICLASS_TIMING_CSN_LEN - ICLASS_TIMING_CSN_PREFIX_LEN;
+}
+
+static IclassTimingRecord* iclass_timing_find(IclassTiming* timing, const uint8_t* csn) {
+    const uint8_t* prefix = iclass_timing_csn_prefix(csn);
+    for(size_t i = 0; i < timing->count; i++) {
+        if(memcmp(timing->entries[i].csn_prefix, prefix, ICLASS_TIMING_CSN_PREFIX_LEN) == 0) {
+            return &timing->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void iclass_timing_load(IclassTiming* timing, Storage* storage) {
+    Stream* stream = file_stream_alloc(storage);
+
+    if(file_stream_open(stream, ICLASS_TIMING_PATH, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        while(timing->count < ICLASS_TIMING_MAX &&
+              stream_read(
+                  stream,
+                  (uint8_t*)&timing->entries[timing->count],
+                  sizeof(IclassTimingRecord)) == sizeof(IclassTimingRecord)) {
+            timing->count++;
+        }
+    }
+    file_stream_close(stream);
+    stream_free(stream);
+}
+
+static bool iclass_timing_save(IclassTiming* timing, Storage* storage) {
+    Stream* stream = file_stream_alloc(storage);
+
+    bool saved = false;
+    if(file_stream_open(stream, ICLASS_TIMING_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        size_t size = timing->count * sizeof(IclassTimingRecord);
+        saved = stream_write(stream, (uint8_t*)timing->entries, size) == size;
+    }
+
+    file_stream_close(stream);
+    stream_free(stream);
+
+    return saved;
+}
+
+IclassTiming* iclass_timing_alloc(void) {
+    IclassTiming* timing = malloc(sizeof(IclassTiming));
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    iclass_timing_load(timing, storage);
+    furi_record_close(RECORD_STORAGE);
+
+    FURI_LOG_D(TAG, "Loaded %zu calibrated card families", timing->count);
+    return timing;
+}
+
+void iclass_timing_free(IclassTiming* timing) {
+    furi_assert(timing);
+
+    free(timing);
+}
+
+size_t iclass_timing_get_count(IclassTiming* timing) {
+    furi_assert(timing);
+
+    return timing->count;
+}
+
+bool iclass_timing_lookup(IclassTiming* timing, const uint8_t* csn, PicopassPollerTiming* result) {
+    furi_assert(timing);
+    furi_assert(csn);
+    furi_assert(result);
+
+    const IclassTimingRecord* record = iclass_timing_find(timing, csn);
+    if(!record) return false;
+
+    result->guard_time_us = record->guard_time_us;
+    result->fdt_poll_fc = record->fdt_poll_fc;
+    result->fdt_poll_poll_us = record->fdt_poll_poll_us;
+    return true;
+}
+
+bool iclass_timing_record(const uint8_t* csn, const PicopassPollerTiming* result) {
+    furi_assert(csn);
+    furi_assert(result);
+
+    IclassTiming* timing = malloc(sizeof(IclassTiming));
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    iclass_timing_load(timing, storage);
+
+    IclassTimingRecord* record = iclass_timing_find(timing, csn);
+    if(!record) {
+        if(timing->count == ICLASS_TIMING_MAX) {
+            memmove(
+                &timing->entries[0],
+                &timing->entries[1],
+                (ICLASS_TIMING_MAX - 1) * sizeof(IclassTimingRecord));
+            timing->count--;
+        }
+        record = &timing->entries[timing->count++];
+        memcpy(record->csn_prefix, iclass_timing_csn_prefix(csn), ICLASS_TIMING_CSN_PREFIX_LEN);
+    }
+    record->guard_time_us = result->guard_time_us;
+    record->fdt_poll_fc = result->fdt_poll_fc;
+    record->fdt_poll_poll_us = result->fdt_poll_poll_us;
+
+    bool saved = iclass_timing_save(timing, storage);
+    if(!saved) FURI_LOG_E(TAG, "Failed to save %s", ICLASS_TIMING_PATH);
+
+    furi_record_close(RECORD_STORAGE);
+    free(timing);
+
+    return saved;
+}
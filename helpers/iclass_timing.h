@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../protocol/picopass_poller.h"
+
+/**
+ * RF timing calibrated per card family. The CSN goes over the air least significant byte first,
+ * its last bytes are the manufacturer and chip type and are what cards are grouped by.
+ */
+
+#define ICLASS_TIMING_MAX            (32)
+#define ICLASS_TIMING_CSN_PREFIX_LEN (4)
+
+typedef struct IclassTiming IclassTiming;
+
+/**
+ * Loads every calibrated card family. Never NULL, empty when nothing was calibrated yet.
+ */
+IclassTiming* iclass_timing_alloc(void);
+
+void iclass_timing_free(IclassTiming* timing);
+
+size_t iclass_timing_get_count(IclassTiming* timing);
+
+/**
+ * Timing calibrated for the family csn belongs to, false if there is none
+ */
+bool iclass_timing_lookup(IclassTiming* timing, const uint8_t* csn, PicopassPollerTiming* result);
+
+/**
+ * Stores result for the family of csn, replacing the oldest family when the list is full
+ */
+bool iclass_timing_record(const uint8_t* csn, const PicopassPollerTiming* result);
@@ -221,6 +221,182 @@ void loclass_opt_doReaderMAC_2(
     loclass_opt_output(div_key_p, &_init, mac);
 }
 
+/**
+ * Bitsliced variant of the reader MAC, used when the same CC/NR has to be checked under many
+ * diversified keys (dictionary and keygen attacks). Instead of one LoclassState_t, every bit of
+ * the 40-bit state is a LoclassLanes_t word holding that bit for LOCLASS_OPT_MULTI_KEYS
+ * independent ciphers, so one pass of loclass_opt_successor_multi() steps all of them at once.
+ *
+ * The boolean forms below are the ones loclass_opt_successor() computes with shifts and LUTs:
+ *  - Tt (bit 0) is the parity of t over the feedback mask 0xc533
+ *  - loclass_opt_select_LUT[r] expands to z0, z1, z2 as in init_opt_select_LUT()
+ *  - k[opt_select] is a three level multiplexer over the eight (per lane) key bytes
+ *  - the two 8-bit additions are ripple carry adders
+ **/
+typedef struct {
+    LoclassLanes_t l[8];
+    LoclassLanes_t r[8];
+    LoclassLanes_t b[8];
+    LoclassLanes_t t[16];
+} LoclassStateMulti_t;
+
+#define LOCLASS_LANES_MUX(a, b, sel) ((a) ^ (((a) ^ (b)) & (sel)))
+
+static inline void loclass_opt_add_multi(
+    const LoclassLanes_t* x,
+    const LoclassLanes_t* y,
+    LoclassLanes_t* sum) {
+    LoclassLanes_t carry = 0;
+#pragma GCC unroll 8
+    for(int i = 0; i < 8; i++) {
+        LoclassLanes_t xy = x[i] ^ y[i];
+        sum[i] = xy ^ carry;
+        carry = (x[i] & y[i]) | (carry & xy);
+    }
+}
+
+static inline void
+    loclass_opt_successor_multi(const LoclassLanes_t k[8][8], LoclassStateMulti_t* s, bool y) {
+    const LoclassLanes_t* t = s->t;
+    const LoclassLanes_t* r = s->r;
+
+    LoclassLanes_t Tt = t[0] ^ t[1] ^ t[4] ^ t[5] ^ t[8] ^ t[10] ^ t[14] ^ t[15];
+    LoclassLanes_t opt_B = s->b[0] ^ s->b[4] ^ s->b[5] ^ s->b[6] ^ r[0];
+
+    LoclassLanes_t z0 = (r[7] & r[5]) ^ (r[6] & ~r[4]) ^ (r[5] | r[3]);
+    LoclassLanes_t z1 = (r[7] | r[5]) ^ (r[2] | r[0]) ^ r[6] ^ r[1];
+    LoclassLanes_t z2 = (r[4] & ~r[2]) ^ (r[3] & r[1]) ^ r[0];
+    LoclassLanes_t sel0 = z2 ^ Tt;
+    LoclassLanes_t sel1 = z1 ^ Tt ^ (y ? ~(LoclassLanes_t)0 : 0);
+    LoclassLanes_t sel2 = z0;
+
+    LoclassLanes_t t_in = Tt ^ r[7] ^ r[3];
+    memmove(&s->t[0], &s->t[1], sizeof(LoclassLanes_t) * 15);
+    s->t[15] = t_in;
+
+    memmove(&s->b[0], &s->b[1], sizeof(LoclassLanes_t) * 7);
+    s->b[7] = opt_B;
+
+    LoclassLanes_t kb[8];
+#pragma GCC unroll 8
+    for(int j = 0; j < 8; j++) {
+        LoclassLanes_t m0 = LOCLASS_LANES_MUX(k[0][j], k[1][j], sel0);
+        LoclassLanes_t m1 = LOCLASS_LANES_MUX(k[2][j], k[3][j], sel0);
+        LoclassLanes_t m2 = LOCLASS_LANES_MUX(k[4][j], k[5][j], sel0);
+        LoclassLanes_t m3 = LOCLASS_LANES_MUX(k[6][j], k[7][j], sel0);
+        m0 = LOCLASS_LANES_MUX(m0, m1, sel1);
+        m2 = LOCLASS_LANES_MUX(m2, m3, sel1);
+        kb[j] = LOCLASS_LANES_MUX(m0, m2, sel2) ^ s->b[j];
+    }
+
+    LoclassLanes_t r_old[8];
+    memcpy(r_old, s->r, sizeof(r_old));
+    loclass_opt_add_multi(kb, s->l, s->r);
+    loclass_opt_add_multi(s->r, r_old, s->l);
+}
+
+static void loclass_opt_init_multi(
+    const uint8_t* div_keys,
+    size_t num_keys,
+    LoclassLanes_t k[8][8],
+    LoclassStateMulti_t* s) {
+    memset(k, 0, sizeof(LoclassLanes_t) * 8 * 8);
+    memset(s, 0, sizeof(LoclassStateMulti_t));
+
+    for(size_t lane = 0; lane < num_keys; lane++) {
+        const uint8_t* key = div_keys + lane * 8;
+        uint8_t l = ((key[0] ^ 0x4c) + 0xEC) & 0xFF;
+        uint8_t r = ((key[0] ^ 0x4c) + 0x21) & 0xFF;
+        for(int j = 0; j < 8; j++) {
+            for(int i = 0; i < 8; i++) {
+                k[i][j] |= (LoclassLanes_t)((key[i] >> j) & 1) << lane;
+            }
+            s->l[j] |= (LoclassLanes_t)((l >> j) & 1) << lane;
+            s->r[j] |= (LoclassLanes_t)((r >> j) & 1) << lane;
+        }
+    }
+
+    // b and t start from the same constants in every lane
+    for(int j = 0; j < 8; j++) {
+        s->b[j] = ((0x4c >> j) & 1) ? ~(LoclassLanes_t)0 : 0;
+    }
+    for(int j = 0; j < 16; j++) {
+        s->t[j] = ((0xE012 >> j) & 1) ? ~(LoclassLanes_t)0 : 0;
+    }
+}
+
+static void loclass_opt_suc_multi(
+    const LoclassLanes_t k[8][8],
+    LoclassStateMulti_t* s,
+    const uint8_t* in,
+    uint8_t length) {
+    for(int i = 0; i < length; i++) {
+        uint8_t head = in[i];
+        for(int j = 0; j < 8; j++) {
+            loclass_opt_successor_multi(k, s, head & 0x01);
+            head >>= 1;
+        }
+    }
+}
+
+void loclass_opt_doReaderMAC_multi(
+    const uint8_t* cc_nr_p,
+    const uint8_t* div_keys,
+    size_t num_keys,
+    uint8_t* macs) {
+    LoclassLanes_t k[8][8];
+    LoclassStateMulti_t s;
+    LoclassLanes_t out[32];
+
+    if(num_keys > LOCLASS_OPT_MULTI_KEYS) num_keys = LOCLASS_OPT_MULTI_KEYS;
+
+    loclass_opt_init_multi(div_keys, num_keys, k, &s);
+    loclass_opt_suc_multi(k, &s, cc_nr_p, 12);
+
+    // Same bit order as loclass_opt_output: bit j of byte i is r2 before step 8 * i + j
+    for(int i = 0; i < 32; i++) {
+        out[i] = s.r[2];
+        loclass_opt_successor_multi(k, &s, false);
+    }
+
+    for(size_t lane = 0; lane < num_keys; lane++) {
+        for(int i = 0; i < 4; i++) {
+            uint8_t bout = 0;
+            for(int j = 0; j < 8; j++) {
+                bout |= ((out[i * 8 + j] >> lane) & 1) << j;
+            }
+            macs[lane * 4 + i] = bout;
+        }
+    }
+}
+
+LoclassLanes_t loclass_opt_checkReaderMAC_multi(
+    const uint8_t* cc_nr_p,
+    const uint8_t* div_keys,
+    size_t num_keys,
+    const uint8_t mac[4]) {
+    LoclassLanes_t k[8][8];
+    LoclassStateMulti_t s;
+
+    if(num_keys > LOCLASS_OPT_MULTI_KEYS) num_keys = LOCLASS_OPT_MULTI_KEYS;
+
+    loclass_opt_init_multi(div_keys, num_keys, k, &s);
+    loclass_opt_suc_multi(k, &s, cc_nr_p, 12);
+
+    LoclassLanes_t match = num_keys == LOCLASS_OPT_MULTI_KEYS ?
+                               ~(LoclassLanes_t)0 :
+                               (((LoclassLanes_t)1 << num_keys) - 1);
+
+    // Compare in the sliced domain, and stop as soon as every lane has diverged
+    for(int i = 0; i < 32 && match; i++) {
+        LoclassLanes_t expected = ((mac[i / 8] >> (i % 8)) & 1) ? ~(LoclassLanes_t)0 : 0;
+        match &= ~(s.r[2] ^ expected);
+        loclass_opt_successor_multi(k, &s, false);
+    }
+
+    return match;
+}
+
 void loclass_doMAC_N(uint8_t* in_p, uint8_t in_size, uint8_t* div_key_p, uint8_t mac[4]) {
     uint8_t dest[] = {0, 0, 0, 0, 0, 0, 0, 0};
     loclass_opt_MAC_N(div_key_p, in_p, in_size, dest);
@@ -302,17 +478,9 @@ void loclass_iclass_calc_div_key(
     uint8_t* div_key,
     bool elite) {
     if(elite) {
-        uint8_t keytable[128] = {0};
-        uint8_t key_index[8] = {0};
-        uint8_t key_sel[8] = {0};
-        uint8_t key_sel_p[8] = {0};
-        loclass_hash2(key, keytable);
-        loclass_hash1(csn, key_index);
-        for(uint8_t i = 0; i < 8; i++) key_sel[i] = keytable[key_index[i]];
-
-        //Permute from iclass format to standard format
-        loclass_permutekey_rev(key_sel, key_sel_p);
-        loclass_diversifyKey(csn, key_sel_p, div_key);
+        uint8_t keytable[LOCLASS_ELITE_KEYTABLE_LEN] = {0};
+        loclass_elite_keytable_prepare(key, keytable);
+        loclass_elite_div_key_from_table(csn, keytable, div_key);
     } else {
         loclass_diversifyKey(csn, key, div_key);
     }
@@ -54,6 +54,17 @@ typedef struct {
     uint16_t t;
 } LoclassState_t;
 
+/**
+ * Lane word for the bitsliced MAC engine, one bit per independent cipher. 32 lanes suit the
+ * Flipper's Cortex-M4, host tools can build with LOCLASS_OPT_MULTI_64 for 64 lanes.
+ **/
+#ifdef LOCLASS_OPT_MULTI_64
+typedef uint64_t LoclassLanes_t;
+#else
+typedef uint32_t LoclassLanes_t;
+#endif
+#define LOCLASS_OPT_MULTI_KEYS (sizeof(LoclassLanes_t) * 8)
+
 /** The reader MAC is MAC(key, CC * NR )
  **/
 void loclass_opt_doReaderMAC(uint8_t* cc_nr_p, uint8_t* div_key_p, uint8_t mac[4]);
@@ -64,6 +75,34 @@ void loclass_opt_doReaderMAC_2(
     uint8_t mac[4],
     const uint8_t* div_key_p);
 
+/**
+ * Bitsliced reader MAC, computes MAC(key, CC * NR) for up to LOCLASS_OPT_MULTI_KEYS keys at once.
+ * Produces the same output as calling loclass_opt_doReaderMAC once per key.
+ * @param cc_nr_p - 12 bytes of CC followed by NR, shared by all keys
+ * @param div_keys - num_keys diversified keys, 8 bytes each
+ * @param num_keys - number of keys, at most LOCLASS_OPT_MULTI_KEYS
+ * @param macs - where to store the MACs, 4 bytes per key
+ */
+void loclass_opt_doReaderMAC_multi(
+    const uint8_t* cc_nr_p,
+    const uint8_t* div_keys,
+    size_t num_keys,
+    uint8_t* macs);
+
+/**
+ * Bitsliced reader MAC check, for attacks that only need to know which key produced a known MAC.
+ * @param cc_nr_p - 12 bytes of CC followed by NR, shared by all keys
+ * @param div_keys - num_keys diversified keys, 8 bytes each
+ * @param num_keys - number of keys, at most LOCLASS_OPT_MULTI_KEYS
+ * @param mac - the reader MAC to look for
+ * @return bit i is set when div_keys[i] produces mac
+ */
+LoclassLanes_t loclass_opt_checkReaderMAC_multi(
+    const uint8_t* cc_nr_p,
+    const uint8_t* div_keys,
+    size_t num_keys,
+    const uint8_t mac[4]);
+
 /**
  * The tag MAC is MAC(key, CC * NR * 32x0))
  */
@@ -0,0 +1,341 @@
+//-----------------------------------------------------------------------------
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// See LICENSE.txt for the text of the license.
+//-----------------------------------------------------------------------------
+// Single-block DES (8-byte ECB) for the loclass key diversification paths.
+//
+// Bit numbering follows FIPS 46: bit 1 is the MSB of the first byte, and a
+// 32-bit half keeps its bit 1 in bit 31.
+//
+// Rounds: the E expansion is never materialised. R rotated right by 1 holds
+// the S1/S3/S5/S7 input groups at shifts 26/18/10/2, and R rotated right by 5
+// holds S8/S2/S4/S6 at the same shifts. Each subkey is stored as the two
+// matching words, so a round is two XORs and eight lookups in
+// loclass_des_sp, which merges every S-box with the P permutation.
+//
+// Key schedule: PC1 is an 8x8 bit transpose of the key, and PC2 is looked up
+// one nibble of C or D at a time in loclass_des_pc2_c/_d. Those tables place
+// the C groups as S1@26 S3@18 S2@10 S4@2 and the D groups as S6@26 S8@18
+// S5@10 S7@2, which the two subkey words are then cut out of.
+//-----------------------------------------------------------------------------
+#include "optimized_des.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static const uint32_t loclass_des_sp[8][64] = {
+    {
+        0x00808200, 0x00000000, 0x00008000, 0x00808202, 0x00808002, 0x00008202,
+        0x00000002, 0x00008000, 0x00000200, 0x00808200, 0x00808202, 0x00000200,
+        0x00800202, 0x00808002, 0x00800000, 0x00000002, 0x00000202, 0x00800200,
+        0x00800200, 0x00008200, 0x00008200, 0x00808000, 0x00808000, 0x00800202,
+        0x00008002, 0x00800002, 0x00800002, 0x00008002, 0x00000000, 0x00000202,
+        0x00008202, 0x00800000, 0x00008000, 0x00808202, 0x00000002, 0x00808000,
+        0x00808200, 0x00800000, 0x00800000, 0x00000200, 0x00808002, 0x00008000,
+        0x00008200, 0x00800002, 0x00000200, 0x00000002, 0x00800202, 0x00008202,
+        0x00808202, 0x00008002, 0x00808000, 0x00800202, 0x00800002, 0x00000202,
+        0x00008202, 0x00808200, 0x00000202, 0x00800200, 0x00800200, 0x00000000,
+        0x00008002, 0x00008200, 0x00000000, 0x00808002,
+    },
+    {
+        0x40084010, 0x40004000, 0x00004000, 0x00084010, 0x00080000, 0x00000010,
+        0x40080010, 0x40004010, 0x40000010, 0x40084010, 0x40084000, 0x40000000,
+        0x40004000, 0x00080000, 0x00000010, 0x40080010, 0x00084000, 0x00080010,
+        0x40004010, 0x00000000, 0x40000000, 0x00004000, 0x00084010, 0x40080000,
+        0x00080010, 0x40000010, 0x00000000, 0x00084000, 0x00004010, 0x40084000,
+        0x40080000, 0x00004010, 0x00000000, 0x00084010, 0x40080010, 0x00080000,
+        0x40004010, 0x40080000, 0x40084000, 0x00004000, 0x40080000, 0x40004000,
+        0x00000010, 0x40084010, 0x00084010, 0x00000010, 0x00004000, 0x40000000,
+        0x00004010, 0x40084000, 0x00080000, 0x40000010, 0x00080010, 0x40004010,
+        0x40000010, 0x00080010, 0x00084000, 0x00000000, 0x40004000, 0x00004010,
+        0x40000000, 0x40080010, 0x40084010, 0x00084000,
+    },
+    {
+        0x00000104, 0x04010100, 0x00000000, 0x04010004, 0x04000100, 0x00000000,
+        0x00010104, 0x04000100, 0x00010004, 0x04000004, 0x04000004, 0x00010000,
+        0x04010104, 0x00010004, 0x04010000, 0x00000104, 0x04000000, 0x00000004,
+        0x04010100, 0x00000100, 0x00010100, 0x04010000, 0x04010004, 0x00010104,
+        0x04000104, 0x00010100, 0x00010000, 0x04000104, 0x00000004, 0x04010104,
+        0x00000100, 0x04000000, 0x04010100, 0x04000000, 0x00010004, 0x00000104,
+        0x00010000, 0x04010100, 0x04000100, 0x00000000, 0x00000100, 0x00010004,
+        0x04010104, 0x04000100, 0x04000004, 0x00000100, 0x00000000, 0x04010004,
+        0x04000104, 0x00010000, 0x04000000, 0x04010104, 0x00000004, 0x00010104,
+        0x00010100, 0x04000004, 0x04010000, 0x04000104, 0x00000104, 0x04010000,
+        0x00010104, 0x00000004, 0x04010004, 0x00010100,
+    },
+    {
+        0x80401000, 0x80001040, 0x80001040, 0x00000040, 0x00401040, 0x80400040,
+        0x80400000, 0x80001000, 0x00000000, 0x00401000, 0x00401000, 0x80401040,
+        0x80000040, 0x00000000, 0x00400040, 0x80400000, 0x80000000, 0x00001000,
+        0x00400000, 0x80401000, 0x00000040, 0x00400000, 0x80001000, 0x00001040,
+        0x80400040, 0x80000000, 0x00001040, 0x00400040, 0x00001000, 0x00401040,
+        0x80401040, 0x80000040, 0x00400040, 0x80400000, 0x00401000, 0x80401040,
+        0x80000040, 0x00000000, 0x00000000, 0x00401000, 0x00001040, 0x00400040,
+        0x80400040, 0x80000000, 0x80401000, 0x80001040, 0x80001040, 0x00000040,
+        0x80401040, 0x80000040, 0x80000000, 0x00001000, 0x80400000, 0x80001000,
+        0x00401040, 0x80400040, 0x80001000, 0x00001040, 0x00400000, 0x80401000,
+        0x00000040, 0x00400000, 0x00001000, 0x00401040,
+    },
+    {
+        0x00000080, 0x01040080, 0x01040000, 0x21000080, 0x00040000, 0x00000080,
+        0x20000000, 0x01040000, 0x20040080, 0x00040000, 0x01000080, 0x20040080,
+        0x21000080, 0x21040000, 0x00040080, 0x20000000, 0x01000000, 0x20040000,
+        0x20040000, 0x00000000, 0x20000080, 0x21040080, 0x21040080, 0x01000080,
+        0x21040000, 0x20000080, 0x00000000, 0x21000000, 0x01040080, 0x01000000,
+        0x21000000, 0x00040080, 0x00040000, 0x21000080, 0x00000080, 0x01000000,
+        0x20000000, 0x01040000, 0x21000080, 0x20040080, 0x01000080, 0x20000000,
+        0x21040000, 0x01040080, 0x20040080, 0x00000080, 0x01000000, 0x21040000,
+        0x21040080, 0x00040080, 0x21000000, 0x21040080, 0x01040000, 0x00000000,
+        0x20040000, 0x21000000, 0x00040080, 0x01000080, 0x20000080, 0x00040000,
+        0x00000000, 0x20040000, 0x01040080, 0x20000080,
+    },
+    {
+        0x10000008, 0x10200000, 0x00002000, 0x10202008, 0x10200000, 0x00000008,
+        0x10202008, 0x00200000, 0x10002000, 0x00202008, 0x00200000, 0x10000008,
+        0x00200008, 0x10002000, 0x10000000, 0x00002008, 0x00000000, 0x00200008,
+        0x10002008, 0x00002000, 0x00202000, 0x10002008, 0x00000008, 0x10200008,
+        0x10200008, 0x00000000, 0x00202008, 0x10202000, 0x00002008, 0x00202000,
+        0x10202000, 0x10000000, 0x10002000, 0x00000008, 0x10200008, 0x00202000,
+        0x10202008, 0x00200000, 0x00002008, 0x10000008, 0x00200000, 0x10002000,
+        0x10000000, 0x00002008, 0x10000008, 0x10202008, 0x00202000, 0x10200000,
+        0x00202008, 0x10202000, 0x00000000, 0x10200008, 0x00000008, 0x00002000,
+        0x10200000, 0x00202008, 0x00002000, 0x00200008, 0x10002008, 0x00000000,
+        0x10202000, 0x10000000, 0x00200008, 0x10002008,
+    },
+    {
+        0x00100000, 0x02100001, 0x02000401, 0x00000000, 0x00000400, 0x02000401,
+        0x00100401, 0x02100400, 0x02100401, 0x00100000, 0x00000000, 0x02000001,
+        0x00000001, 0x02000000, 0x02100001, 0x00000401, 0x02000400, 0x00100401,
+        0x00100001, 0x02000400, 0x02000001, 0x02100000, 0x02100400, 0x00100001,
+        0x02100000, 0x00000400, 0x00000401, 0x02100401, 0x00100400, 0x00000001,
+        0x02000000, 0x00100400, 0x02000000, 0x00100400, 0x00100000, 0x02000401,
+        0x02000401, 0x02100001, 0x02100001, 0x00000001, 0x00100001, 0x02000000,
+        0x02000400, 0x00100000, 0x02100400, 0x00000401, 0x00100401, 0x02100400,
+        0x00000401, 0x02000001, 0x02100401, 0x02100000, 0x00100400, 0x00000000,
+        0x00000001, 0x02100401, 0x00000000, 0x00100401, 0x02100000, 0x00000400,
+        0x02000001, 0x02000400, 0x00000400, 0x00100001,
+    },
+    {
+        0x08000820, 0x00000800, 0x00020000, 0x08020820, 0x08000000, 0x08000820,
+        0x00000020, 0x08000000, 0x00020020, 0x08020000, 0x08020820, 0x00020800,
+        0x08020800, 0x00020820, 0x00000800, 0x00000020, 0x08020000, 0x08000020,
+        0x08000800, 0x00000820, 0x00020800, 0x00020020, 0x08020020, 0x08020800,
+        0x00000820, 0x00000000, 0x00000000, 0x08020020, 0x08000020, 0x08000800,
+        0x00020820, 0x00020000, 0x00020820, 0x00020000, 0x08020800, 0x00000800,
+        0x00000020, 0x08020020, 0x00000800, 0x00020820, 0x08000800, 0x00000020,
+        0x08000020, 0x08020000, 0x08020020, 0x08000000, 0x00020000, 0x08000820,
+        0x00000000, 0x08020820, 0x00020020, 0x08000020, 0x08020000, 0x08000800,
+        0x08000820, 0x00000000, 0x08020820, 0x00020800, 0x00020800, 0x00000820,
+        0x00000820, 0x00020020, 0x08000000, 0x08020800,
+    },
+};
+static const uint32_t loclass_des_pc2_c[7][16] = {
+    {
+        0x00000000, 0x00100000, 0x00008000, 0x00108000,
+        0x00000004, 0x00100004, 0x00008004, 0x00108004,
+        0x08000000, 0x08100000, 0x08008000, 0x08108000,
+        0x08000004, 0x08100004, 0x08008004, 0x08108004,
+    },
+    {
+        0x00000000, 0x00040000, 0x00000040, 0x00040040,
+        0x00001000, 0x00041000, 0x00001040, 0x00041040,
+        0x04000000, 0x04040000, 0x04000040, 0x04040040,
+        0x04001000, 0x04041000, 0x04001040, 0x04041040,
+    },
+    {
+        0x00000000, 0x00200000, 0x20000000, 0x20200000,
+        0x00000400, 0x00200400, 0x20000400, 0x20200400,
+        0x00000000, 0x00200000, 0x20000000, 0x20200000,
+        0x00000400, 0x00200400, 0x20000400, 0x20200400,
+    },
+    {
+        0x00000000, 0x00000080, 0x00002000, 0x00002080,
+        0x80000000, 0x80000080, 0x80002000, 0x80002080,
+        0x00000008, 0x00000088, 0x00002008, 0x00002088,
+        0x80000008, 0x80000088, 0x80002008, 0x80002088,
+    },
+    {
+        0x00000000, 0x00000010, 0x00400000, 0x00400010,
+        0x00000000, 0x00000010, 0x00400000, 0x00400010,
+        0x40000000, 0x40000010, 0x40400000, 0x40400010,
+        0x40000000, 0x40000010, 0x40400000, 0x40400010,
+    },
+    {
+        0x00000000, 0x10000000, 0x00800000, 0x10800000,
+        0x00000000, 0x10000000, 0x00800000, 0x10800000,
+        0x00000800, 0x10000800, 0x00800800, 0x10800800,
+        0x00000800, 0x10000800, 0x00800800, 0x10800800,
+    },
+    {
+        0x00000000, 0x00004000, 0x00000020, 0x00004020,
+        0x00080000, 0x00084000, 0x00080020, 0x00084020,
+        0x00000000, 0x00004000, 0x00000020, 0x00004020,
+        0x00080000, 0x00084000, 0x00080020, 0x00084020,
+    },
+};
+static const uint32_t loclass_des_pc2_d[7][16] = {
+    {
+        0x00000000, 0x00040000, 0x00002000, 0x00042000,
+        0x80000000, 0x80040000, 0x80002000, 0x80042000,
+        0x00080000, 0x000C0000, 0x00082000, 0x000C2000,
+        0x80080000, 0x800C0000, 0x80082000, 0x800C2000,
+    },
+    {
+        0x00000000, 0x00100000, 0x00000000, 0x00100000,
+        0x00000008, 0x00100008, 0x00000008, 0x00100008,
+        0x08000000, 0x08100000, 0x08000000, 0x08100000,
+        0x08000008, 0x08100008, 0x08000008, 0x08100008,
+    },
+    {
+        0x00000000, 0x40000000, 0x00000020, 0x40000020,
+        0x00000000, 0x40000000, 0x00000020, 0x40000020,
+        0x00001000, 0x40001000, 0x00001020, 0x40001020,
+        0x00001000, 0x40001000, 0x00001020, 0x40001020,
+    },
+    {
+        0x00000000, 0x00000080, 0x00000000, 0x00000080,
+        0x00400000, 0x00400080, 0x00400000, 0x00400080,
+        0x00008000, 0x00008080, 0x00008000, 0x00008080,
+        0x00408000, 0x00408080, 0x00408000, 0x00408080,
+    },
+    {
+        0x00000000, 0x04000000, 0x00000800, 0x04000800,
+        0x00800000, 0x04800000, 0x00800800, 0x04800800,
+        0x10000000, 0x14000000, 0x10000800, 0x14000800,
+        0x10800000, 0x14800000, 0x10800800, 0x14800800,
+    },
+    {
+        0x00000000, 0x00004000, 0x20000000, 0x20004000,
+        0x00200000, 0x00204000, 0x20200000, 0x20204000,
+        0x00000040, 0x00004040, 0x20000040, 0x20004040,
+        0x00200040, 0x00204040, 0x20200040, 0x20204040,
+    },
+    {
+        0x00000000, 0x00000010, 0x00000400, 0x00000410,
+        0x00000000, 0x00000010, 0x00000400, 0x00000410,
+        0x00000004, 0x00000014, 0x00000404, 0x00000414,
+        0x00000004, 0x00000014, 0x00000404, 0x00000414,
+    },
+};
+
+static const uint8_t loclass_des_rotations[16] = {1, 1, 2, 2, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 2, 1};
+
+#define LOCLASS_DES_ROR(x, n)   (((x) >> (n)) | ((x) << (32 - (n))))
+#define LOCLASS_DES_ROL28(x, n) ((((x) << (n)) | ((x) >> (28 - (n)))) & 0x0FFFFFFF)
+
+// Swaps the bits of B selected by M with the bits of A S positions above them
+#define LOCLASS_DES_SWAP(A, B, S, M)             \
+    do {                                         \
+        uint32_t t = (((A) >> (S)) ^ (B)) & (M); \
+        (B) ^= t;                                \
+        (A) ^= t << (S);                         \
+    } while(0)
+
+static inline uint32_t loclass_des_load32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void loclass_des_store32(uint32_t v, uint8_t* p) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static inline uint32_t loclass_des_pc2_lookup(const uint32_t tab[7][16], uint32_t half) {
+    return tab[0][(half >> 24) & 0xF] | tab[1][(half >> 20) & 0xF] | tab[2][(half >> 16) & 0xF] |
+           tab[3][(half >> 12) & 0xF] | tab[4][(half >> 8) & 0xF] | tab[5][(half >> 4) & 0xF] |
+           tab[6][half & 0xF];
+}
+
+static void loclass_des_expand(uint32_t sk[32], const uint8_t key[8]) {
+    // Transpose with key[7] on top, so row c holds bit column c of key[7] ... key[0]
+    uint64_t x = 0;
+    for(int i = 7; i >= 0; i--) x = (x << 8) | key[i];
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x ^= t ^ (t << 28);
+
+    uint32_t row[7];
+    for(int c = 0; c < 7; c++) row[c] = (x >> (56 - 8 * c)) & 0xFF;
+
+    // PC1
+    uint32_t c28 = (row[0] << 20) | (row[1] << 12) | (row[2] << 4) | (row[3] >> 4);
+    uint32_t d28 = (row[6] << 20) | (row[5] << 12) | (row[4] << 4) | (row[3] & 0xF);
+
+    for(int i = 0; i < 16; i++) {
+        c28 = LOCLASS_DES_ROL28(c28, loclass_des_rotations[i]);
+        d28 = LOCLASS_DES_ROL28(d28, loclass_des_rotations[i]);
+        uint32_t wc = loclass_des_pc2_lookup(loclass_des_pc2_c, c28);
+        uint32_t wd = loclass_des_pc2_lookup(loclass_des_pc2_d, d28);
+        sk[2 * i] = (wc & 0xFCFC0000) | (wd & 0x0000FCFC);
+        sk[2 * i + 1] = ((wc & 0x0000FCFC) << 8) | LOCLASS_DES_ROR(wd & 0xFCFC0000, 24);
+    }
+}
+
+void loclass_des_setkey_enc(LoclassDesSchedule_t* sched, const uint8_t key[8]) {
+    loclass_des_expand(sched->sk, key);
+}
+
+void loclass_des_setkey_dec(LoclassDesSchedule_t* sched, const uint8_t key[8]) {
+    uint32_t sk[32];
+    loclass_des_expand(sk, key);
+    for(int i = 0; i < 16; i++) {
+        sched->sk[2 * i] = sk[30 - 2 * i];
+        sched->sk[2 * i + 1] = sk[31 - 2 * i];
+    }
+}
+
+static inline uint32_t loclass_des_f(uint32_t r, const uint32_t* k) {
+    uint32_t t1 = LOCLASS_DES_ROR(r, 1) ^ k[0];
+    uint32_t t2 = LOCLASS_DES_ROR(r, 5) ^ k[1];
+    return loclass_des_sp[0][(t1 >> 26) & 0x3F] | loclass_des_sp[2][(t1 >> 18) & 0x3F] |
+           loclass_des_sp[4][(t1 >> 10) & 0x3F] | loclass_des_sp[6][(t1 >> 2) & 0x3F] |
+           loclass_des_sp[7][(t2 >> 26) & 0x3F] | loclass_des_sp[1][(t2 >> 18) & 0x3F] |
+           loclass_des_sp[3][(t2 >> 10) & 0x3F] | loclass_des_sp[5][(t2 >> 2) & 0x3F];
+}
+
+void loclass_des_crypt_ecb(
+    const LoclassDesSchedule_t* sched,
+    const uint8_t input[8],
+    uint8_t output[8]) {
+    uint32_t l = loclass_des_load32(input);
+    uint32_t r = loclass_des_load32(input + 4);
+
+    // IP
+    LOCLASS_DES_SWAP(l, r, 4, 0x0F0F0F0F);
+    LOCLASS_DES_SWAP(l, r, 16, 0x0000FFFF);
+    LOCLASS_DES_SWAP(r, l, 2, 0x33333333);
+    LOCLASS_DES_SWAP(r, l, 8, 0x00FF00FF);
+    LOCLASS_DES_SWAP(l, r, 1, 0x55555555);
+
+    const uint32_t* k = sched->sk;
+    for(int i = 0; i < 8; i++) {
+        l ^= loclass_des_f(r, k);
+        r ^= loclass_des_f(l, k + 2);
+        k += 4;
+    }
+
+    // FP, on the swapped halves
+    LOCLASS_DES_SWAP(r, l, 1, 0x55555555);
+    LOCLASS_DES_SWAP(l, r, 8, 0x00FF00FF);
+    LOCLASS_DES_SWAP(l, r, 2, 0x33333333);
+    LOCLASS_DES_SWAP(r, l, 16, 0x0000FFFF);
+    LOCLASS_DES_SWAP(r, l, 4, 0x0F0F0F0F);
+
+    loclass_des_store32(r, output);
+    loclass_des_store32(l, output + 4);
+}
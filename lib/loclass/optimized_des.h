@@ -0,0 +1,59 @@
+//-----------------------------------------------------------------------------
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// See LICENSE.txt for the text of the license.
+//-----------------------------------------------------------------------------
+// Single-block DES (8-byte ECB) for the loclass key diversification paths.
+//
+// loclass_diversifyKey() and loclass_hash2() run one DES block per key, so
+// the mbedtls context setup used to cost as much as the cipher itself. Here
+// the key schedule is a plain object that can be prepared once and reused,
+// and both the schedule and the rounds are table-driven.
+//-----------------------------------------------------------------------------
+#ifndef LOCLASS_DES_H
+#define LOCLASS_DES_H
+
+#include <stdint.h>
+
+/**
+ * Expanded DES key: 16 rounds of two 32-bit subkey words, in the order
+ * they are applied (reversed for decryption)
+ **/
+typedef struct {
+    uint32_t sk[32];
+} LoclassDesSchedule_t;
+
+/**
+ * @brief Prepares an encryption schedule for a key in standard DES format
+ * @param sched
+ * @param key 8 bytes, parity bits are ignored
+ */
+void loclass_des_setkey_enc(LoclassDesSchedule_t* sched, const uint8_t key[8]);
+
+/**
+ * @brief Prepares a decryption schedule for a key in standard DES format
+ * @param sched
+ * @param key 8 bytes, parity bits are ignored
+ */
+void loclass_des_setkey_dec(LoclassDesSchedule_t* sched, const uint8_t key[8]);
+
+/**
+ * @brief Runs one 8-byte block through a prepared schedule
+ * @param sched
+ * @param input
+ * @param output may alias input
+ */
+void loclass_des_crypt_ecb(
+    const LoclassDesSchedule_t* sched,
+    const uint8_t input[8],
+    uint8_t output[8]);
+
+#endif // LOCLASS_DES_H
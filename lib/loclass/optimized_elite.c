@@ -36,7 +36,6 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
-#include <mbedtls/des.h>
 #include "optimized_ikeys.h"
 
 /**
@@ -162,21 +161,20 @@ static void loclass_rk(const uint8_t* key, uint8_t n, uint8_t* outp_key) {
     return;
 }
 
-static mbedtls_des_context loclass_ctx_enc;
-static mbedtls_des_context loclass_ctx_dec;
-
 static void loclass_desdecrypt_iclass(uint8_t* iclass_key, uint8_t* input, uint8_t* output) {
     uint8_t key_std_format[8] = {0};
+    LoclassDesSchedule_t sched;
     loclass_permutekey_rev(iclass_key, key_std_format);
-    mbedtls_des_setkey_dec(&loclass_ctx_dec, key_std_format);
-    mbedtls_des_crypt_ecb(&loclass_ctx_dec, input, output);
+    loclass_des_setkey_dec(&sched, key_std_format);
+    loclass_des_crypt_ecb(&sched, input, output);
 }
 
 static void loclass_desencrypt_iclass(const uint8_t* iclass_key, uint8_t* input, uint8_t* output) {
     uint8_t key_std_format[8] = {0};
+    LoclassDesSchedule_t sched;
     loclass_permutekey_rev(iclass_key, key_std_format);
-    mbedtls_des_setkey_enc(&loclass_ctx_enc, key_std_format);
-    mbedtls_des_crypt_ecb(&loclass_ctx_enc, input, output);
+    loclass_des_setkey_enc(&sched, key_std_format);
+    loclass_des_crypt_ecb(&sched, input, output);
 }
 
 /**
@@ -230,3 +228,49 @@ void loclass_hash2(const uint8_t* key64, uint8_t* outp_keytable) {
         }
     }
 }
+
+void loclass_elite_keytable_prepare(const uint8_t* key, uint8_t* keytable) {
+    loclass_hash2(key, keytable);
+}
+
+void loclass_elite_div_key_from_table(
+    const uint8_t* csn,
+    const uint8_t* keytable,
+    uint8_t* div_key) {
+    uint8_t key_index[8] = {0};
+    uint8_t key_sel[8] = {0};
+    uint8_t key_sel_p[8] = {0};
+    loclass_hash1(csn, key_index);
+    for(uint8_t i = 0; i < 8; i++) key_sel[i] = keytable[key_index[i]];
+
+    //Permute from iclass format to standard format
+    loclass_permutekey_rev(key_sel, key_sel_p);
+    loclass_diversifyKey(csn, key_sel_p, div_key);
+}
+
+void loclass_elite_keytable_cache_init(LoclassEliteKeytableCache_t* cache) {
+    memset(cache, 0, sizeof(LoclassEliteKeytableCache_t));
+}
+
+const uint8_t*
+    loclass_elite_keytable_cache_get(LoclassEliteKeytableCache_t* cache, const uint8_t* key) {
+    LoclassEliteKeytableEntry_t* victim = &cache->entries[0];
+
+    cache->clock++;
+    for(int i = 0; i < LOCLASS_ELITE_KEYTABLE_CACHE_SIZE; i++) {
+        LoclassEliteKeytableEntry_t* entry = &cache->entries[i];
+        if(entry->valid && memcmp(entry->key, key, 8) == 0) {
+            entry->last_used = cache->clock;
+            return entry->keytable;
+        }
+        // Prefer empty slots, then the least recently used one
+        if(!victim->valid) continue;
+        if(!entry->valid || entry->last_used < victim->last_used) victim = entry;
+    }
+
+    memcpy(victim->key, key, 8);
+    loclass_elite_keytable_prepare(key, victim->keytable);
+    victim->last_used = cache->clock;
+    victim->valid = true;
+    return victim->keytable;
+}
@@ -37,6 +37,25 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <stdbool.h>
+
+#define LOCLASS_ELITE_KEYTABLE_LEN        128
+#define LOCLASS_ELITE_KEYTABLE_CACHE_SIZE 4
+
+typedef struct {
+    uint8_t key[8];
+    uint8_t keytable[LOCLASS_ELITE_KEYTABLE_LEN];
+    uint32_t last_used;
+    bool valid;
+} LoclassEliteKeytableEntry_t;
+
+/**
+ * Small LRU of prepared keytables, keyed by the elite master key
+ **/
+typedef struct {
+    LoclassEliteKeytableEntry_t entries[LOCLASS_ELITE_KEYTABLE_CACHE_SIZE];
+    uint32_t clock;
+} LoclassEliteKeytableCache_t;
 
 void loclass_permutekey(const uint8_t key[8], uint8_t dest[8]);
 /**
@@ -55,4 +74,33 @@ void loclass_permutekey_rev(const uint8_t key[8], uint8_t dest[8]);
 void loclass_hash1(const uint8_t* csn, uint8_t* k);
 void loclass_hash2(const uint8_t* key64, uint8_t* outp_keytable);
 
+/**
+ * Computes the 128 byte keytable for an elite master key. It only depends on the key, so it can
+ * be computed once and reused for every CSN diversified under that key.
+ * @param key elite master key
+ * @param keytable output, LOCLASS_ELITE_KEYTABLE_LEN bytes
+ */
+void loclass_elite_keytable_prepare(const uint8_t* key, uint8_t* keytable);
+/**
+ * Elite key diversification from a keytable made by loclass_elite_keytable_prepare.
+ * Same result as loclass_iclass_calc_div_key with elite set.
+ * @param csn
+ * @param keytable
+ * @param div_key output (8 bytes)
+ */
+void loclass_elite_div_key_from_table(
+    const uint8_t* csn,
+    const uint8_t* keytable,
+    uint8_t* div_key);
+
+void loclass_elite_keytable_cache_init(LoclassEliteKeytableCache_t* cache);
+/**
+ * Returns the keytable for key, preparing it in place of the least recently used entry on a miss.
+ * @param cache
+ * @param key elite master key
+ * @return keytable, valid until the entry is evicted
+ */
+const uint8_t*
+    loclass_elite_keytable_cache_get(LoclassEliteKeytableCache_t* cache, const uint8_t* key);
+
 #endif
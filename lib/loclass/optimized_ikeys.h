@@ -36,6 +36,8 @@
 #define IKEYS_H
 
 #include <inttypes.h>
+#include <stddef.h>
+#include "optimized_des.h"
 
 /**
  * @brief
@@ -57,6 +59,30 @@ void loclass_hash0(uint64_t c, uint8_t k[8]);
  */
 
 void loclass_diversifyKey(const uint8_t* csn, const uint8_t* key, uint8_t* div_key);
+
+/**
+ * @brief Same as loclass_diversifyKey, for a key whose DES schedule is already prepared
+ * @param csn
+ * @param sched loclass_des_setkey_enc() of the key, reusable across CSNs
+ * @param div_key
+ */
+void loclass_diversifyKey_sched(
+    const uint8_t* csn,
+    const LoclassDesSchedule_t* sched,
+    uint8_t* div_key);
+
+/**
+ * @brief Diversifies many keys against one CSN, for dictionary and keygen runs
+ * @param csn
+ * @param keys num_keys keys of 8 bytes each
+ * @param num_keys
+ * @param div_keys where the num_keys diversified keys are put (8 bytes each)
+ */
+void loclass_diversifyKey_batch(
+    const uint8_t* csn,
+    const uint8_t* keys,
+    size_t num_keys,
+    uint8_t* div_keys);
 /**
  * @brief Permutes a key from standard NIST format to Iclass specific format
  * @param key
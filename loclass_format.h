@@ -0,0 +1,64 @@
+#pragma once
+
+// On-disk layout of .loclass.bin, shared by loclass_writer.c and the host tools in tools/.
+//
+// The file is a sequence of 32-byte units, always little endian. Every collection session
+// starts with a header (LoclassFormatHeader and its CSN table, padded to a whole number of
+// units), followed by one LoclassFormatRecord per event. Sessions are appended, so a reader
+// has to accept a new header anywhere a record could be. Records never start with the
+// header magic, their first byte is a LoclassFormatRecordType.
+
+#include <stdint.h>
+
+#define LOCLASS_FORMAT_MAGIC       "LOCLASSB"
+#define LOCLASS_FORMAT_MAGIC_LEN   (8)
+#define LOCLASS_FORMAT_VERSION     (2)
+// Version 1 only differs in log_no, see LoclassFormatRecord
+#define LOCLASS_FORMAT_VERSION_MIN (1)
+#define LOCLASS_FORMAT_RECORD_SIZE (32)
+#define LOCLASS_FORMAT_CSN_LEN     (8)
+#define LOCLASS_FORMAT_MAX_CSNS    (255)
+
+#define LOCLASS_FORMAT_HEADER_SIZE(num_csns)                              \
+    ((sizeof(LoclassFormatHeader) + (num_csns) * LOCLASS_FORMAT_CSN_LEN + \
+      LOCLASS_FORMAT_RECORD_SIZE - 1) /                                   \
+     LOCLASS_FORMAT_RECORD_SIZE * LOCLASS_FORMAT_RECORD_SIZE)
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic[LOCLASS_FORMAT_MAGIC_LEN];
+    uint16_t version;
+    // This struct, the CSN table and its padding
+    uint16_t header_size;
+    uint16_t record_size;
+    uint8_t num_csns;
+    uint8_t num_per_csn;
+    // Unix time the session started, records store seconds relative to it
+    uint32_t ts_base;
+    uint8_t reserved[12];
+    // Followed by num_csns CSNs of LOCLASS_FORMAT_CSN_LEN bytes
+} LoclassFormatHeader;
+
+typedef enum {
+    LoclassFormatRecordTypeMac = 1,
+    LoclassFormatRecordTypeStarted = 2,
+    LoclassFormatRecordTypeFinished = 3,
+} LoclassFormatRecordType;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    // Index into the CSN table of the session header
+    uint8_t csn_index;
+    // Version 1 stored log_no here, wrapping after 256 MACs
+    uint8_t log_no_v1;
+    uint8_t reserved0;
+    uint32_t ts_offset;
+    uint8_t epurse[8];
+    uint8_t nr[4];
+    uint8_t mac[4];
+    // MACs collected in the session before this one
+    uint32_t log_no;
+    uint8_t reserved[4];
+} LoclassFormatRecord;
+
+_Static_assert(sizeof(LoclassFormatHeader) == LOCLASS_FORMAT_RECORD_SIZE, "header size");
+_Static_assert(sizeof(LoclassFormatRecord) == LOCLASS_FORMAT_RECORD_SIZE, "record size");
@@ -0,0 +1,132 @@
+#include "loclass_plan.h"
+#include "picopass_device.h"
+
+#include <furi/furi.h>
+#include <flipper_format/flipper_format.h>
+
+#define TAG "LoclassPlan"
+
+#define LOCLASS_PLAN_PATH APP_DATA_PATH("loclass.plan")
+
+static const char* loclass_plan_file_header = "Flipper Picopass loclass plan";
+static const uint32_t loclass_plan_file_version = 1;
+
+// CSNs from Proxmark3 repo
+static const uint8_t loclass_plan_default_csns[LOCLASS_NUM_CSNS][LOCLASS_PLAN_CSN_LEN] = {
+    {0x01, 0x0A, 0x0F, 0xFF, 0xF7, 0xFF, 0x12, 0xE0},
+    {0x0C, 0x06, 0x0C, 0xFE, 0xF7, 0xFF, 0x12, 0xE0},
+    {0x10, 0x97, 0x83, 0x7B, 0xF7, 0xFF, 0x12, 0xE0},
+    {0x13, 0x97, 0x82, 0x7A, 0xF7, 0xFF, 0x12, 0xE0},
+    {0x07, 0x0E, 0x0D, 0xF9, 0xF7, 0xFF, 0x12, 0xE0},
+    {0x14, 0x96, 0x84, 0x76, 0xF7, 0xFF, 0x12, 0xE0},
+    {0x17, 0x96, 0x85, 0x71, 0xF7, 0xFF, 0x12, 0xE0},
+    {0xCE, 0xC5, 0x0F, 0x77, 0xF7, 0xFF, 0x12, 0xE0},
+    {0xD2, 0x5A, 0x82, 0xF8, 0xF7, 0xFF, 0x12, 0xE0},
+};
+
+static LoclassPlan* loclass_plan_alloc_csns(uint8_t num_csns) {
+    LoclassPlan* plan = malloc(sizeof(LoclassPlan));
+    plan->csns = malloc(num_csns * LOCLASS_PLAN_CSN_LEN);
+    plan->num_csns = num_csns;
+    plan->num_per_csn = LOCLASS_NUM_PER_CSN;
+    plan->passes = 1;
+    return plan;
+}
+
+static LoclassPlan* loclass_plan_load(FlipperFormat* file) {
+    LoclassPlan* plan = NULL;
+    FuriString* temp_str = furi_string_alloc();
+    bool parsed = false;
+
+    do {
+        uint32_t version = 0;
+        if(!flipper_format_read_header(file, temp_str, &version)) break;
+        if(!furi_string_equal_str(temp_str, loclass_plan_file_header) ||
+           version != loclass_plan_file_version) {
+            break;
+        }
+
+        uint32_t num_per_csn = 0;
+        uint32_t passes = 0;
+        uint32_t num_csns = 0;
+        if(!flipper_format_read_uint32(file, "Per CSN", &num_per_csn, 1)) break;
+        if(!flipper_format_read_uint32(file, "Passes", &passes, 1)) break;
+        if(!flipper_format_read_uint32(file, "CSNs", &num_csns, 1)) break;
+        if(num_per_csn == 0 || num_per_csn > LOCLASS_PLAN_MAX_PER_CSN || num_csns == 0 ||
+           num_csns > LOCLASS_PLAN_MAX_CSNS) {
+            FURI_LOG_E(TAG, "Plan out of range: %lu CSNs, %lu per CSN", num_csns, num_per_csn);
+            break;
+        }
+
+        plan = loclass_plan_alloc_csns(num_csns);
+        plan->num_per_csn = num_per_csn;
+        plan->passes = passes;
+
+        bool csns_read = true;
+        for(size_t i = 0; i < num_csns; i++) {
+            furi_string_printf(temp_str, "CSN %zu", i);
+            if(!flipper_format_read_hex(
+                   file, furi_string_get_cstr(temp_str), plan->csns[i], LOCLASS_PLAN_CSN_LEN)) {
+                csns_read = false;
+                break;
+            }
+        }
+        if(!csns_read) break;
+
+        parsed = true;
+    } while(false);
+
+    if(!parsed && plan) {
+        loclass_plan_free(plan);
+        plan = NULL;
+    }
+    furi_string_free(temp_str);
+
+    return plan;
+}
+
+LoclassPlan* loclass_plan_alloc(Storage* storage) {
+    furi_assert(storage);
+
+    LoclassPlan* plan = NULL;
+    if(storage_common_stat(storage, LOCLASS_PLAN_PATH, NULL) == FSE_OK) {
+        FlipperFormat* file = flipper_format_file_alloc(storage);
+        if(flipper_format_file_open_existing(file, LOCLASS_PLAN_PATH)) {
+            plan = loclass_plan_load(file);
+        }
+        flipper_format_free(file);
+        if(!plan) FURI_LOG_E(TAG, "Failed to load %s", LOCLASS_PLAN_PATH);
+    } else {
+        plan = loclass_plan_alloc_csns(LOCLASS_NUM_CSNS);
+        memcpy(plan->csns, loclass_plan_default_csns, sizeof(loclass_plan_default_csns));
+    }
+
+    if(plan) {
+        FURI_LOG_I(
+            TAG,
+            "%u CSNs, %u per CSN, %lu passes",
+            plan->num_csns,
+            plan->num_per_csn,
+            plan->passes);
+    }
+    return plan;
+}
+
+void loclass_plan_free(LoclassPlan* plan) {
+    furi_assert(plan);
+
+    free(plan->csns);
+    free(plan);
+}
+
+uint32_t loclass_plan_get_total(const LoclassPlan* plan) {
+    furi_assert(plan);
+
+    return plan->passes * plan->num_csns * plan->num_per_csn;
+}
+
+const uint8_t* loclass_plan_get_csn(const LoclassPlan* plan, uint32_t num_macs) {
+    furi_assert(plan);
+
+    return plan->csns[(num_macs / plan->num_per_csn) % plan->num_csns];
+}
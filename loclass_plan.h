@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <storage/storage.h>
+
+#define LOCLASS_PLAN_CSN_LEN (8)
+#define LOCLASS_PLAN_MAX_CSNS (255)
+#define LOCLASS_PLAN_MAX_PER_CSN (64)
+
+/**
+ * What the loclass listener presents to the reader: each CSN in turn for num_per_csn MACs,
+ * going through the list passes times (0 keeps going until the user skips).
+ */
+typedef struct {
+    uint8_t (*csns)[LOCLASS_PLAN_CSN_LEN];
+    uint8_t num_csns;
+    uint8_t num_per_csn;
+    uint32_t passes;
+} LoclassPlan;
+
+/**
+ * Loads the plan from LOCLASS_PLAN_PATH if there is one, the default proxmark3 CSNs otherwise.
+ * Returns NULL if the plan file exists but can't be parsed.
+ */
+LoclassPlan* loclass_plan_alloc(Storage* storage);
+
+void loclass_plan_free(LoclassPlan* plan);
+
+/**
+ * MACs to collect before the plan is done, 0 if it never is
+ */
+uint32_t loclass_plan_get_total(const LoclassPlan* plan);
+
+/**
+ * CSN to present once num_macs MACs were collected
+ */
+const uint8_t* loclass_plan_get_csn(const LoclassPlan* plan, uint32_t num_macs);
@@ -1,4 +1,5 @@
 #include "loclass_writer.h"
+#include "loclass_format.h"
 
 #include <furi/furi.h>
 #include <furi_hal.h>
@@ -6,20 +7,135 @@
 #include <stream/stream.h>
 #include <stream/buffered_file_stream.h>
 #include <datetime/datetime.h>
+#include <stdatomic.h>
+
+// Records are only encoded in the NFC listener callback, a dedicated thread does the storage
+// writes so SD card latency can't make the listener miss the reader's next frame.
+#define LOCLASS_WRITER_RING_MIN   (32) // records, power of two
+#define LOCLASS_WRITER_STACK_SIZE (1024)
+#define LOCLASS_WRITER_FLAG_DATA  (1UL << 0)
+#define LOCLASS_WRITER_FLAG_STOP  (1UL << 1)
 
 struct LoclassWriter {
     Stream* file_stream;
+    const uint8_t* csns;
+    uint8_t num_csns;
+    uint32_t ts_base;
+
+    FuriThread* thread;
+    // Single producer (listener callback), single consumer (writer thread), no locks:
+    // head is only stored by the producer and tail only by the consumer
+    LoclassFormatRecord* ring;
+    uint32_t ring_size;
+    atomic_uint_fast32_t head;
+    atomic_uint_fast32_t tail;
+    atomic_uint_fast32_t written;
+    atomic_uint_fast32_t dropped;
 };
 
-#define LOCLASS_LOGS_PATH EXT_PATH("apps_data/picopass/.loclass.log")
+#define LOCLASS_LOGS_PATH EXT_PATH("apps_data/picopass/.loclass.bin")
+
+static uint32_t loclass_writer_timestamp() {
+    DateTime curr_dt;
+    furi_hal_rtc_get_datetime(&curr_dt);
+    return datetime_datetime_to_timestamp(&curr_dt);
+}
+
+static bool loclass_writer_write_header(LoclassWriter* instance, uint8_t num_per_csn) {
+    static const uint8_t padding[LOCLASS_FORMAT_RECORD_SIZE] = {0};
+
+    LoclassFormatHeader header = {
+        .version = LOCLASS_FORMAT_VERSION,
+        .header_size = LOCLASS_FORMAT_HEADER_SIZE(instance->num_csns),
+        .record_size = LOCLASS_FORMAT_RECORD_SIZE,
+        .num_csns = instance->num_csns,
+        .num_per_csn = num_per_csn,
+        .ts_base = instance->ts_base,
+    };
+    memcpy(header.magic, LOCLASS_FORMAT_MAGIC, LOCLASS_FORMAT_MAGIC_LEN);
+
+    size_t table_size = instance->num_csns * LOCLASS_FORMAT_CSN_LEN;
+    size_t padding_size = header.header_size - sizeof(header) - table_size;
+
+    return stream_write(instance->file_stream, (const uint8_t*)&header, sizeof(header)) ==
+               sizeof(header) &&
+           stream_write(instance->file_stream, instance->csns, table_size) ==
+               table_size &&
+           stream_write(instance->file_stream, padding, padding_size) == padding_size;
+}
+
+static bool loclass_writer_enqueue(LoclassWriter* instance, LoclassFormatRecord* record) {
+    record->ts_offset = loclass_writer_timestamp() - instance->ts_base;
+
+    uint32_t head = atomic_load_explicit(&instance->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&instance->tail, memory_order_acquire);
+    if(head - tail == instance->ring_size) {
+        atomic_fetch_add_explicit(&instance->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    instance->ring[head % instance->ring_size] = *record;
+    atomic_store_explicit(&instance->head, head + 1, memory_order_release);
+    furi_thread_flags_set(furi_thread_get_id(instance->thread), LOCLASS_WRITER_FLAG_DATA);
+    return true;
+}
+
+static void loclass_writer_drain(LoclassWriter* instance) {
+    uint32_t tail = atomic_load_explicit(&instance->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&instance->head, memory_order_acquire);
+
+    while(tail != head) {
+        // Longest run before the ring wraps, so each batch is a single stream write
+        uint32_t index = tail % instance->ring_size;
+        uint32_t count = MIN(head - tail, instance->ring_size - index);
+        size_t size = count * sizeof(LoclassFormatRecord);
+
+        if(stream_write(instance->file_stream, (const uint8_t*)&instance->ring[index], size) ==
+           size) {
+            atomic_fetch_add_explicit(&instance->written, count, memory_order_relaxed);
+        } else {
+            atomic_fetch_add_explicit(&instance->dropped, count, memory_order_relaxed);
+        }
+
+        tail += count;
+        atomic_store_explicit(&instance->tail, tail, memory_order_release);
+    }
+}
 
-LoclassWriter* loclass_writer_alloc() {
+static int32_t loclass_writer_thread(void* context) {
+    LoclassWriter* instance = context;
+
+    bool running = true;
+    while(running) {
+        uint32_t flags = furi_thread_flags_wait(
+            LOCLASS_WRITER_FLAG_DATA | LOCLASS_WRITER_FLAG_STOP, FuriFlagWaitAny, FuriWaitForever);
+        if(flags & FuriFlagError) continue;
+        // Whatever was queued before the stop request still gets written
+        if(flags & LOCLASS_WRITER_FLAG_STOP) running = false;
+        loclass_writer_drain(instance);
+    }
+
+    return 0;
+}
+
+LoclassWriter* loclass_writer_alloc(const uint8_t* csns, uint8_t num_csns, uint8_t num_per_csn) {
     LoclassWriter* instance = malloc(sizeof(LoclassWriter));
+    memset(instance, 0, sizeof(LoclassWriter));
+    instance->csns = csns;
+    instance->num_csns = num_csns;
+    instance->ts_base = loclass_writer_timestamp();
+    // The listener queues a whole CSN's MACs at once, the previous CSN's may not be written yet
+    instance->ring_size = LOCLASS_WRITER_RING_MIN;
+    while(instance->ring_size < 2 * num_per_csn) {
+        instance->ring_size *= 2;
+    }
+
     Storage* storage = furi_record_open(RECORD_STORAGE);
     instance->file_stream = buffered_file_stream_alloc(storage);
     storage_simply_mkdir(storage, STORAGE_APP_DATA_PATH_PREFIX);
     if(!buffered_file_stream_open(
-           instance->file_stream, LOCLASS_LOGS_PATH, FSAM_WRITE, FSOM_OPEN_APPEND)) {
+           instance->file_stream, LOCLASS_LOGS_PATH, FSAM_WRITE, FSOM_OPEN_APPEND) ||
+       !loclass_writer_write_header(instance, num_per_csn)) {
         buffered_file_stream_close(instance->file_stream);
         stream_free(instance->file_stream);
         free(instance);
@@ -28,77 +144,72 @@ LoclassWriter* loclass_writer_alloc() {
 
     furi_record_close(RECORD_STORAGE);
 
+    if(instance) {
+        instance->ring = malloc(instance->ring_size * sizeof(LoclassFormatRecord));
+        instance->thread = furi_thread_alloc_ex(
+            "LoclassWriter", LOCLASS_WRITER_STACK_SIZE, loclass_writer_thread, instance);
+        furi_thread_start(instance->thread);
+    }
+
     return instance;
 }
 
 void loclass_writer_free(LoclassWriter* instance) {
     furi_assert(instance != NULL);
 
+    furi_thread_flags_set(furi_thread_get_id(instance->thread), LOCLASS_WRITER_FLAG_STOP);
+    furi_thread_join(instance->thread);
+    furi_thread_free(instance->thread);
+
     buffered_file_stream_close(instance->file_stream);
     stream_free(instance->file_stream);
+    free(instance->ring);
     free(instance);
 }
 
 bool loclass_writer_write_start_stop(LoclassWriter* instance, bool start) {
     furi_assert(instance != NULL);
 
-    DateTime curr_dt;
-    furi_hal_rtc_get_datetime(&curr_dt);
-    uint32_t curr_ts = datetime_datetime_to_timestamp(&curr_dt);
-
-    FuriString* str = furi_string_alloc_printf(
-        "loclass-v1-info ts %lu %s\n", curr_ts, start ? "started" : "finished");
-    bool write_success = stream_write_string(instance->file_stream, str);
-    furi_string_free(str);
-    return write_success;
+    LoclassFormatRecord record = {
+        .type = start ? LoclassFormatRecordTypeStarted : LoclassFormatRecordTypeFinished,
+    };
+    return loclass_writer_enqueue(instance, &record);
 }
 
 bool loclass_writer_write_params(
     LoclassWriter* instance,
-    uint8_t log_no,
+    uint32_t log_no,
     const uint8_t csn[8],
     const uint8_t epurse[8],
     const uint8_t nr[4],
     const uint8_t mac[4]) {
     furi_assert(instance != NULL);
 
-    DateTime curr_dt;
-    furi_hal_rtc_get_datetime(&curr_dt);
-    uint32_t curr_ts = datetime_datetime_to_timestamp(&curr_dt);
-
-    FuriString* str = furi_string_alloc_printf(
-        "loclass-v1-mac ts %lu no %u "
-        "csn %02x%02x%02x%02x%02x%02x%02x%02x "
-        "cc %02x%02x%02x%02x%02x%02x%02x%02x "
-        "nr %02x%02x%02x%02x "
-        "mac %02x%02x%02x%02x\n",
-        curr_ts,
-        log_no,
-        csn[0],
-        csn[1],
-        csn[2],
-        csn[3],
-        csn[4],
-        csn[5],
-        csn[6],
-        csn[7],
-        epurse[0],
-        epurse[1],
-        epurse[2],
-        epurse[3],
-        epurse[4],
-        epurse[5],
-        epurse[6],
-        epurse[7],
-        nr[0],
-        nr[1],
-        nr[2],
-        nr[3],
-        mac[0],
-        mac[1],
-        mac[2],
-        mac[3]);
-    bool write_success = stream_write_string(instance->file_stream, str);
-    furi_string_free(str);
-    return write_success;
+    LoclassFormatRecord record = {
+        .type = LoclassFormatRecordTypeMac,
+        .log_no = log_no,
+    };
+    const uint8_t* table_csn = instance->csns;
+    uint8_t csn_index = 0;
+    while(csn_index < instance->num_csns && memcmp(table_csn, csn, LOCLASS_FORMAT_CSN_LEN) != 0) {
+        csn_index++;
+        table_csn += LOCLASS_FORMAT_CSN_LEN;
+    }
+    furi_assert(csn_index < instance->num_csns);
+    record.csn_index = csn_index;
+    memcpy(record.epurse, epurse, sizeof(record.epurse));
+    memcpy(record.nr, nr, sizeof(record.nr));
+    memcpy(record.mac, mac, sizeof(record.mac));
+
+    return loclass_writer_enqueue(instance, &record);
+}
+
+void loclass_writer_get_stats(LoclassWriter* instance, LoclassWriterStats* stats) {
+    furi_assert(instance != NULL);
+
+    uint32_t tail = atomic_load_explicit(&instance->tail, memory_order_acquire);
+    uint32_t head = atomic_load_explicit(&instance->head, memory_order_acquire);
+    stats->queued = head - tail;
+    stats->written = atomic_load_explicit(&instance->written, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&instance->dropped, memory_order_relaxed);
 }
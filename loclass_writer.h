@@ -5,16 +5,36 @@
 
 typedef struct LoclassWriter LoclassWriter;
 
-LoclassWriter* loclass_writer_alloc();
+typedef struct {
+    // Accepted but not yet written to storage
+    uint32_t queued;
+    uint32_t written;
+    // Ring was full, or the storage write failed
+    uint32_t dropped;
+} LoclassWriterStats;
+
+/**
+ * Opens .loclass.bin for appending and writes a session header with the CSNs that will be
+ * presented, in order: num_csns CSNs of 8 bytes back to back. csns must stay valid for the
+ * lifetime of the writer. The queue is sized so two CSNs' worth of MACs fit.
+ */
+LoclassWriter* loclass_writer_alloc(const uint8_t* csns, uint8_t num_csns, uint8_t num_per_csn);
 
 void loclass_writer_free(LoclassWriter* instance);
 
+/**
+ * The write functions only queue a record for the writer thread and never touch storage, so
+ * they are safe to call from the NFC listener callback. They return false if the record had
+ * to be dropped.
+ */
 bool loclass_writer_write_start_stop(LoclassWriter* instance, bool start);
 
 bool loclass_writer_write_params(
     LoclassWriter* instance,
-    uint8_t log_no,
+    uint32_t log_no,
     const uint8_t csn[8],
     const uint8_t epurse[8],
     const uint8_t nr[4],
     const uint8_t mac[4]);
+
+void loclass_writer_get_stats(LoclassWriter* instance, LoclassWriterStats* stats);
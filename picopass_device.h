@@ -13,6 +13,7 @@
 #include "helpers/iclass_elite_dict.h"
 #include "picopass_wiegand.h"
 
+// Default loclass collection plan, used when there is no loclass.plan file
 #define LOCLASS_NUM_CSNS 9
 #ifndef LOCLASS_NUM_PER_CSN
 // Collect 2 MACs per CSN to account for keyroll modes by default
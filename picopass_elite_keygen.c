@@ -4,46 +4,68 @@
 
 #define INITIAL_SEED 0x429080
 
-uint32_t seed = INITIAL_SEED;
-uint8_t key_state[8];
-bool prepared = false;
-
-void picopass_elite_reset() {
-    memset(key_state, 0, sizeof(key_state));
-    seed = INITIAL_SEED;
-    prepared = false;
-}
+#define PICOPASS_ELITE_LCG_MASK (PICOPASS_ELITE_KEYGEN_PERIOD - 1) // mod 2^24
+#define PICOPASS_ELITE_LCG_A    (0xFD43FD)
+#define PICOPASS_ELITE_LCG_C    (0xC39EC3)
 
-uint32_t picopass_elite_lcg() {
-    uint32_t mod = 0x1000000; // 2^24,
-    uint32_t a = 0xFD43FD;
-    uint32_t c = 0xC39EC3;
+void picopass_elite_keygen_reset(PicopassEliteKeygen* keygen) {
+    memset(keygen->key_state, 0, sizeof(keygen->key_state));
+    keygen->seed = INITIAL_SEED;
+    keygen->prepared = false;
+}
 
-    return (a * seed + c) % mod;
+static uint32_t picopass_elite_lcg(uint32_t seed) {
+    return (PICOPASS_ELITE_LCG_A * seed + PICOPASS_ELITE_LCG_C) & PICOPASS_ELITE_LCG_MASK;
 }
 
-uint32_t picopass_elite_rng() {
-    seed = picopass_elite_lcg();
-    return seed;
+// seed after steps LCG steps. Composing x -> a * x + c with itself gives another affine map, so
+// the maps for 1, 2, 4, ... steps are squared up and the ones in steps applied
+static uint32_t picopass_elite_lcg_jump(uint32_t seed, uint32_t steps) {
+    uint32_t a = PICOPASS_ELITE_LCG_A;
+    uint32_t c = PICOPASS_ELITE_LCG_C;
+    uint32_t acc_a = 1;
+    uint32_t acc_c = 0;
+
+    for(; steps; steps >>= 1) {
+        if(steps & 1) {
+            acc_a = (a * acc_a) & PICOPASS_ELITE_LCG_MASK;
+            acc_c = (a * acc_c + c) & PICOPASS_ELITE_LCG_MASK;
+        }
+        c = (a * c + c) & PICOPASS_ELITE_LCG_MASK;
+        a = (a * a) & PICOPASS_ELITE_LCG_MASK;
+    }
+
+    return (acc_a * seed + acc_c) & PICOPASS_ELITE_LCG_MASK;
 }
 
-uint8_t picopass_elite_nextByte() {
-    return (picopass_elite_rng() >> 16) & 0xFF;
+static uint8_t picopass_elite_nextByte(PicopassEliteKeygen* keygen) {
+    keygen->seed = picopass_elite_lcg(keygen->seed);
+    return (keygen->seed >> 16) & 0xFF;
 }
 
-void picopass_elite_nextKey(uint8_t* key) {
-    if(prepared) {
+void picopass_elite_keygen_next_key(PicopassEliteKeygen* keygen, uint8_t* key) {
+    if(keygen->prepared) {
         for(size_t i = 0; i < 7; i++) {
-            key_state[i] = key_state[i + 1];
+            keygen->key_state[i] = keygen->key_state[i + 1];
         }
-        key_state[7] = picopass_elite_nextByte();
+        keygen->key_state[7] = picopass_elite_nextByte(keygen);
     } else {
         for(size_t i = 0; i < 8; i++) {
-            key_state[i] = picopass_elite_nextByte();
+            keygen->key_state[i] = picopass_elite_nextByte(keygen);
         }
-        prepared = true;
+        keygen->prepared = true;
     }
-    memcpy(key, key_state, 8);
+    memcpy(key, keygen->key_state, 8);
+}
+
+void picopass_elite_keygen_seek(PicopassEliteKeygen* keygen, uint32_t index) {
+    picopass_elite_keygen_reset(keygen);
+    if(index == 0) return;
+
+    // Load key index - 1, the next call slides the window onto key index
+    keygen->seed = picopass_elite_lcg_jump(INITIAL_SEED, index - 1);
+    uint8_t key[8];
+    picopass_elite_keygen_next_key(keygen, key);
 }
 
 /*
@@ -6,5 +6,24 @@
 #include <stdio.h>
 #include <string.h>
 
-void picopass_elite_nextKey(uint8_t* key);
-void picopass_elite_reset();
+/**
+ * Keys are 8 byte windows sliding one byte at a time over the output of a 24 bit LCG, so key N
+ * is bytes N to N + 7 of the stream. Each context is independent and can be copied to save it.
+ */
+typedef struct {
+    uint32_t seed;
+    uint8_t key_state[8];
+    bool prepared;
+} PicopassEliteKeygen;
+
+// Every LCG state is visited once before the stream repeats
+#define PICOPASS_ELITE_KEYGEN_PERIOD (0x1000000UL)
+
+void picopass_elite_keygen_reset(PicopassEliteKeygen* keygen);
+
+void picopass_elite_keygen_next_key(PicopassEliteKeygen* keygen, uint8_t* key);
+
+/**
+ * Positions keygen so the next key is key index, in O(log index) LCG steps
+ */
+void picopass_elite_keygen_seek(PicopassEliteKeygen* keygen, uint32_t index);
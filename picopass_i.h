@@ -30,16 +30,16 @@
 #include <picopass_icons.h>
 
 #include <nfc/nfc.h>
-#include <toolbox/keys_dict.h>
 #include "protocol/picopass_poller.h"
 #include "protocol/picopass_listener.h"
+#include "helpers/iclass_key_hits.h"
+#include "helpers/iclass_key_iter.h"
+#include "helpers/iclass_attack_journal.h"
+#include "helpers/iclass_attack_telemetry.h"
+#include "helpers/iclass_timing.h"
 
 #define PICOPASS_TEXT_STORE_SIZE 129
 
-#define PICOPASS_ICLASS_ELITE_DICT_FLIPPER_NAME    APP_ASSETS_PATH("iclass_elite_dict.txt")
-#define PICOPASS_ICLASS_STANDARD_DICT_FLIPPER_NAME APP_ASSETS_PATH("iclass_standard_dict.txt")
-#define PICOPASS_ICLASS_ELITE_DICT_USER_NAME       APP_DATA_PATH("assets/iclass_elite_dict_user.txt")
-
 enum PicopassCustomEvent {
     // Reserve first 100 events for button types and indexes, starting from 0
     PicopassCustomEventReserved = 100,
@@ -53,6 +53,7 @@ enum PicopassCustomEvent {
     PicopassCustomEventLoclassGotMac,
     PicopassCustomEventLoclassGotStandardKey,
     PicopassCustomEventNrMacSaved,
+    PicopassCustomEventBatchReadUpdate,
 
     PicopassCustomEventPollerSuccess,
     PicopassCustomEventPollerFail,
@@ -68,6 +69,13 @@ typedef struct {
     uint16_t total_keys;
     uint16_t current_key;
     bool card_detected;
+    IclassKeySource source;
+    bool skip_source;
+    // Card the iterator belongs to, its journal is saved when another card or exit comes
+    uint8_t csn[PICOPASS_BLOCK_LEN];
+    bool csn_valid;
+    bool attack_done;
+    IclassAttackTelemetry telemetry;
 } PicopassDictAttackContext;
 
 typedef struct {
@@ -77,8 +85,28 @@ typedef struct {
 
 typedef struct {
     size_t macs_collected;
+    // From the collection plan, 0 collects until skipped
+    size_t macs_to_collect;
 } PicopassLoclassContext;
 
+typedef struct {
+    // Cards found in the field by the last anticollision round
+    size_t cards;
+    size_t read;
+    size_t saved;
+    size_t failed;
+    // Handed over by the poller thread, saved from the scene's
+    FuriMessageQueue* cards_read;
+} PicopassBatchReadContext;
+
+typedef struct {
+    // The card as saved, dev_data gets what was read
+    PicopassDeviceData reference;
+    PicopassPollerDelta delta;
+    // The key the reference was read with went out before the dictionaries
+    bool reference_key_sent;
+} PicopassDeltaReadContext;
+
 typedef enum {
     ManualNRMAC,
     AutoNRMAC
@@ -94,7 +122,7 @@ struct Picopass {
     Nfc* nfc;
     PicopassPoller* poller;
     PicopassListener* listener;
-    KeysDict* dict;
+    IclassKeyIter* key_iter;
     uint32_t last_error_notify_ticks;
 
     char text_store[PICOPASS_TEXT_STORE_SIZE];
@@ -115,6 +143,9 @@ struct Picopass {
     PicopassDictAttackContext dict_attack_ctx;
     PicopassWriteKeyContext write_key_context;
     PicopassLoclassContext loclass_context;
+    PicopassBatchReadContext batch_read_ctx;
+    PicopassPollerTiming calibrated_timing;
+    PicopassDeltaReadContext delta_read_ctx;
 
     NRMACType nr_mac_type;
 };
@@ -22,27 +22,13 @@ typedef struct {
     PicopassListenerCommandHandler handler;
 } PicopassListenerCmd;
 
-// CSNs from Proxmark3 repo
-static const uint8_t loclass_csns[LOCLASS_NUM_CSNS][PICOPASS_BLOCK_LEN] = {
-    {0x01, 0x0A, 0x0F, 0xFF, 0xF7, 0xFF, 0x12, 0xE0},
-    {0x0C, 0x06, 0x0C, 0xFE, 0xF7, 0xFF, 0x12, 0xE0},
-    {0x10, 0x97, 0x83, 0x7B, 0xF7, 0xFF, 0x12, 0xE0},
-    {0x13, 0x97, 0x82, 0x7A, 0xF7, 0xFF, 0x12, 0xE0},
-    {0x07, 0x0E, 0x0D, 0xF9, 0xF7, 0xFF, 0x12, 0xE0},
-    {0x14, 0x96, 0x84, 0x76, 0xF7, 0xFF, 0x12, 0xE0},
-    {0x17, 0x96, 0x85, 0x71, 0xF7, 0xFF, 0x12, 0xE0},
-    {0xCE, 0xC5, 0x0F, 0x77, 0xF7, 0xFF, 0x12, 0xE0},
-    {0xD2, 0x5A, 0x82, 0xF8, 0xF7, 0xFF, 0x12, 0xE0},
-};
-
 static void picopass_listener_reset(PicopassListener* instance) {
     instance->state = PicopassListenerStateIdle;
 }
 
 static void picopass_listener_loclass_update_csn(PicopassListener* instance) {
-    // collect LOCLASS_NUM_PER_CSN nonces in a row for each CSN
-    const uint8_t* csn =
-        loclass_csns[(instance->key_block_num / LOCLASS_NUM_PER_CSN) % LOCLASS_NUM_CSNS];
+    // collect num_per_csn nonces in a row for each CSN
+    const uint8_t* csn = loclass_plan_get_csn(instance->loclass_plan, instance->loclass_num_macs);
     memcpy(instance->data->card_data[PICOPASS_CSN_BLOCK_INDEX].data, csn, PICOPASS_BLOCK_LEN);
 
     uint8_t key[PICOPASS_BLOCK_LEN] = {};
@@ -273,28 +259,30 @@ PicopassListenerCommand
 #endif
 
         // Save to buffer to defer flushing when we rotate CSN
+        const LoclassPlan* plan = instance->loclass_plan;
         memcpy(
-            instance->loclass_mac_buffer + ((instance->key_block_num % LOCLASS_NUM_PER_CSN) * 8),
+            instance->loclass_mac_buffer + ((instance->loclass_num_macs % plan->num_per_csn) * 8),
             &rx_data[1],
             8);
 
         // Rotate to the next CSN/attempt
-        instance->key_block_num++;
+        instance->loclass_num_macs++;
 
         // CSN changed
-        if(instance->key_block_num % LOCLASS_NUM_PER_CSN == 0) {
-            // Flush NR-MACs for this CSN to SD card
-            for(int i = 0; i < LOCLASS_NUM_PER_CSN; i++) {
+        if(instance->loclass_num_macs % plan->num_per_csn == 0) {
+            // Queue NR-MACs for this CSN, the writer thread flushes them to SD card
+            for(int i = 0; i < plan->num_per_csn; i++) {
                 loclass_writer_write_params(
                     instance->writer,
-                    instance->key_block_num + i - LOCLASS_NUM_PER_CSN,
+                    instance->loclass_num_macs + i - plan->num_per_csn,
                     instance->data->card_data[PICOPASS_CSN_BLOCK_INDEX].data,
                     instance->data->card_data[PICOPASS_SECURE_EPURSE_BLOCK_INDEX].data,
                     instance->loclass_mac_buffer + (i * 8),
                     instance->loclass_mac_buffer + (i * 8) + 4);
             }
 
-            if(instance->key_block_num < LOCLASS_NUM_CSNS * LOCLASS_NUM_PER_CSN) {
+            uint32_t total = loclass_plan_get_total(plan);
+            if(total == 0 || instance->loclass_num_macs < total) {
                 picopass_listener_loclass_update_csn(instance);
                 // Only reset the state when we change to a new CSN for the same reason as when we get a standard key
                 instance->state = PicopassListenerStateIdle;
@@ -569,7 +557,7 @@ PicopassListenerCommand
         if(instance->state != PicopassListenerStateSelected) break;
 
         uint8_t block_start = bit_buffer_get_byte(buf, 1);
-        if(block_start + 4 >= PICOPASS_MAX_APP_LIMIT) break;
+        if(block_start + 4 > PICOPASS_MAX_APP_LIMIT) break;
 
         bool secured = (instance->data->card_data[PICOPASS_CONFIG_BLOCK_INDEX].data[7] &
                         PICOPASS_FUSE_CRYPT10) != PICOPASS_FUSE_CRYPT0;
@@ -689,6 +677,10 @@ void picopass_listener_free(PicopassListener* instance) {
         loclass_writer_write_start_stop(instance->writer, false);
         loclass_writer_free(instance->writer);
     }
+    if(instance->loclass_plan) {
+        loclass_plan_free(instance->loclass_plan);
+        free(instance->loclass_mac_buffer);
+    }
     free(instance);
 }
 
@@ -699,8 +691,20 @@ bool picopass_listener_set_mode(PicopassListener* instance, PicopassListenerMode
     instance->mode = mode;
     if(instance->mode == PicopassListenerModeLoclass) {
         instance->key_block_num = 0;
+        instance->loclass_num_macs = 0;
+
+        Storage* storage = furi_record_open(RECORD_STORAGE);
+        instance->loclass_plan = loclass_plan_alloc(storage);
+        furi_record_close(RECORD_STORAGE);
+        if(!instance->loclass_plan) return false;
+
+        // Sized once for the plan, the listener callback never allocates
+        instance->loclass_mac_buffer = malloc(8 * instance->loclass_plan->num_per_csn);
         picopass_listener_loclass_update_csn(instance);
-        instance->writer = loclass_writer_alloc();
+        instance->writer = loclass_writer_alloc(
+            &instance->loclass_plan->csns[0][0],
+            instance->loclass_plan->num_csns,
+            instance->loclass_plan->num_per_csn);
         if(instance->writer) {
             loclass_writer_write_start_stop(instance->writer, true);
         } else {
@@ -766,3 +770,20 @@ const PicopassDeviceData* picopass_listener_get_data(PicopassListener* instance)
 
     return instance->data;
 }
+
+void picopass_listener_get_loclass_stats(PicopassListener* instance, LoclassWriterStats* stats) {
+    furi_assert(instance);
+    furi_assert(stats);
+
+    if(instance->writer) {
+        loclass_writer_get_stats(instance->writer, stats);
+    } else {
+        memset(stats, 0, sizeof(LoclassWriterStats));
+    }
+}
+
+const LoclassPlan* picopass_listener_get_loclass_plan(PicopassListener* instance) {
+    furi_assert(instance);
+
+    return instance->loclass_plan;
+}
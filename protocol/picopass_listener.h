@@ -2,6 +2,8 @@
 
 #include <nfc/nfc.h>
 #include "picopass_protocol.h"
+#include <loclass_writer.h>
+#include <loclass_plan.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,6 +42,13 @@ void picopass_listener_stop(PicopassListener* instance);
 
 const PicopassDeviceData* picopass_listener_get_data(PicopassListener* instance);
 
+void picopass_listener_get_loclass_stats(PicopassListener* instance, LoclassWriterStats* stats);
+
+/**
+ * Collection plan in use, NULL outside of loclass mode
+ */
+const LoclassPlan* picopass_listener_get_loclass_plan(PicopassListener* instance);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,7 @@
 #include <optimized_ikeys.h>
 #include <optimized_cipher.h>
 #include <loclass_writer.h>
+#include <loclass_plan.h>
 
 #define TAG "PicopassListener"
 
@@ -31,7 +32,9 @@ struct PicopassListener {
     uint8_t key_block_num;
 
     LoclassWriter* writer;
-    uint8_t loclass_mac_buffer[8 * LOCLASS_NUM_PER_CSN];
+    LoclassPlan* loclass_plan;
+    uint32_t loclass_num_macs;
+    uint8_t* loclass_mac_buffer;
 
     PicopassListenerEvent event;
     PicopassListenerCallback callback;
@@ -8,10 +8,287 @@
 
 #define TAG "Picopass"
 
+#define PICOPASS_POLLER_PREFETCH_FLAG_KEY  (1UL << 0)
+#define PICOPASS_POLLER_PREFETCH_FLAG_STOP (1UL << 1)
+
+#define PICOPASS_POLLER_DETECT_FAST_DELAY_MS (5)
+#define PICOPASS_POLLER_DETECT_FAST_ATTEMPTS (20)
+#define PICOPASS_POLLER_DETECT_IDLE_DELAY_MS (100)
+
 typedef NfcCommand (*PicopassPollerStateHandler)(PicopassPoller* instance);
 
+static const PicopassPollerTiming
+    picopass_poller_timing_profiles[PicopassPollerTimingProfileNum] = {
+    [PicopassPollerTimingProfileDefault] =
+        {
+            .guard_time_us = 10000,
+            .fdt_poll_fc = 5000,
+            .fdt_poll_poll_us = 1000,
+        },
+    [PicopassPollerTimingProfileFast] =
+        {
+            .guard_time_us = 1000,
+            .fdt_poll_fc = 4192,
+            .fdt_poll_poll_us = 100,
+        },
+};
+
+// Calibration stops narrowing a value down once it is within a step
+static const uint32_t picopass_poller_calibrate_step[PicopassPollerTimingParamNum] = {
+    [PicopassPollerTimingParamGuardTime] = 250,
+    [PicopassPollerTimingParamFdtPoll] = 64,
+    [PicopassPollerTimingParamFdtPollPoll] = 50,
+};
+
 static void picopass_poller_reset(PicopassPoller* instance) {
     instance->current_block = 0;
+    instance->offline_key_found = false;
+    instance->read4_failed = false;
+    instance->success_reported = false;
+    memset(&instance->calibration, 0, sizeof(PicopassPollerCalibration));
+}
+
+static void
+    picopass_poller_apply_timing(PicopassPoller* instance, const PicopassPollerTiming* timing) {
+    nfc_set_guard_time_us(instance->nfc, timing->guard_time_us);
+    nfc_set_fdt_poll_fc(instance->nfc, timing->fdt_poll_fc);
+    nfc_set_fdt_poll_poll_us(instance->nfc, timing->fdt_poll_poll_us);
+}
+
+static uint32_t*
+    picopass_poller_timing_param(PicopassPollerTiming* timing, PicopassPollerTimingParam param) {
+    switch(param) {
+    case PicopassPollerTimingParamGuardTime:
+        return &timing->guard_time_us;
+    case PicopassPollerTimingParamFdtPoll:
+        return &timing->fdt_poll_fc;
+    default:
+        return &timing->fdt_poll_poll_us;
+    }
+}
+
+static void picopass_poller_diversify(
+    LoclassEliteKeytableCache_t* keytable_cache,
+    IclassDivTable* div_table,
+    const uint8_t* csn,
+    const uint8_t* key,
+    uint8_t* div_key,
+    bool is_elite_key) {
+    if(is_elite_key) {
+        // hash2 only depends on the key, reuse it when the same key comes around again
+        const uint8_t* keytable = loclass_elite_keytable_cache_get(keytable_cache, key);
+        loclass_elite_div_key_from_table(csn, keytable, div_key);
+    } else if(!div_table || !iclass_div_table_lookup(div_table, csn, key, div_key)) {
+        loclass_diversifyKey(csn, key, div_key);
+    }
+}
+
+static void picopass_poller_calc_div_key(
+    PicopassPoller* instance,
+    const uint8_t* key,
+    uint8_t* div_key,
+    bool is_elite_key) {
+    uint32_t start = picopass_poller_cycles();
+    picopass_poller_diversify(
+        &instance->keytable_cache,
+        instance->div_table,
+        instance->serial_num.data,
+        key,
+        div_key,
+        is_elite_key);
+    instance->stats.div_key_cycles += picopass_poller_cycles() - start;
+}
+
+static int32_t picopass_poller_prefetch_thread(void* context) {
+    PicopassPoller* instance = context;
+
+    bool running = true;
+    while(running) {
+        uint32_t flags = furi_thread_flags_wait(
+            PICOPASS_POLLER_PREFETCH_FLAG_KEY | PICOPASS_POLLER_PREFETCH_FLAG_STOP,
+            FuriFlagWaitAny,
+            FuriWaitForever);
+        if(flags & FuriFlagError) continue;
+        if(flags & PICOPASS_POLLER_PREFETCH_FLAG_KEY) {
+            PicopassPollerPrefetch* prefetch = &instance->prefetch;
+            picopass_poller_diversify(
+                &instance->prefetch_keytable_cache,
+                instance->div_table,
+                prefetch->csn,
+                prefetch->key,
+                prefetch->div_key,
+                prefetch->is_elite_key);
+            uint8_t ccnr[12] = {};
+            memcpy(ccnr, prefetch->cc, PICOPASS_BLOCK_LEN);
+            loclass_opt_doReaderMAC(ccnr, prefetch->div_key, prefetch->mac.data);
+            furi_semaphore_release(instance->prefetch_done);
+        }
+        if(flags & PICOPASS_POLLER_PREFETCH_FLAG_STOP) running = false;
+    }
+
+    return 0;
+}
+
+// Asks the scene for the key after the current one and diversifies it in the background
+static NfcCommand picopass_poller_prefetch_key(PicopassPoller* instance) {
+    instance->event.type = PicopassPollerEventTypeRequestKey;
+    NfcCommand command = instance->callback(instance->event, instance->context);
+    if(command != NfcCommandContinue || !instance->event_data.req_key.is_key_provided) {
+        return command;
+    }
+
+    if(!instance->prefetch_thread) {
+        instance->prefetch_done = furi_semaphore_alloc(1, 0);
+        loclass_elite_keytable_cache_init(&instance->prefetch_keytable_cache);
+        instance->prefetch_thread = furi_thread_alloc_ex(
+            "PicopassPrefetch",
+            PICOPASS_POLLER_PREFETCH_STACK_SIZE,
+            picopass_poller_prefetch_thread,
+            instance);
+        furi_thread_start(instance->prefetch_thread);
+    }
+
+    PicopassPollerPrefetch* prefetch = &instance->prefetch;
+    memcpy(prefetch->key, instance->event_data.req_key.key, PICOPASS_KEY_LEN);
+    prefetch->is_elite_key = instance->event_data.req_key.is_elite_key;
+    memcpy(prefetch->csn, instance->serial_num.data, PICOPASS_BLOCK_LEN);
+    memcpy(prefetch->cc, instance->expected_cc, PICOPASS_BLOCK_LEN);
+    instance->prefetch_pending = true;
+    furi_thread_flags_set(
+        furi_thread_get_id(instance->prefetch_thread), PICOPASS_POLLER_PREFETCH_FLAG_KEY);
+
+    return command;
+}
+
+// Takes the prefetched key, true if its div key and MAC are good for the card selected now
+static bool picopass_poller_take_prefetched_key(
+    PicopassPoller* instance,
+    uint8_t* key,
+    bool* is_elite_key,
+    uint8_t* div_key,
+    uint8_t* cc,
+    PicopassMac* mac) {
+    PicopassPollerPrefetch* prefetch = &instance->prefetch;
+
+    uint32_t start = picopass_poller_cycles();
+    furi_semaphore_acquire(instance->prefetch_done, FuriWaitForever);
+    instance->stats.prefetch_wait_cycles += picopass_poller_cycles() - start;
+    instance->prefetch_pending = false;
+    memcpy(key, prefetch->key, PICOPASS_KEY_LEN);
+    *is_elite_key = prefetch->is_elite_key;
+    if(memcmp(prefetch->csn, instance->serial_num.data, PICOPASS_BLOCK_LEN) != 0) return false;
+    memcpy(div_key, prefetch->div_key, PICOPASS_KEY_LEN);
+    memcpy(cc, prefetch->cc, PICOPASS_BLOCK_LEN);
+    *mac = prefetch->mac;
+
+    return true;
+}
+
+// Waits out a key the prefetch thread is diversifying, it stays pending for the auth handler
+static void picopass_poller_prefetch_sync(PicopassPoller* instance) {
+    if(!instance->prefetch_pending) return;
+    furi_semaphore_acquire(instance->prefetch_done, FuriWaitForever);
+    furi_semaphore_release(instance->prefetch_done);
+}
+
+// Waits out a key the prefetch thread is diversifying and forgets it
+static void picopass_poller_prefetch_drop(PicopassPoller* instance) {
+    if(!instance->prefetch_pending) return;
+    furi_semaphore_acquire(instance->prefetch_done, FuriWaitForever);
+    instance->prefetch_pending = false;
+}
+
+static void
+    picopass_poller_push_pending_key(PicopassPoller* instance, const uint8_t* key, bool elite) {
+    if(instance->num_pending_keys == PICOPASS_POLLER_PENDING_KEYS) {
+        FURI_LOG_W(TAG, "No room for a pending key");
+        return;
+    }
+    PicopassPollerKey* pending = &instance->pending_keys[instance->num_pending_keys++];
+    memcpy(pending->key, key, PICOPASS_KEY_LEN);
+    pending->is_elite_key = elite;
+    memcpy(instance->pending_csn, instance->serial_num.data, PICOPASS_BLOCK_LEN);
+}
+
+static bool picopass_poller_pop_pending_key(PicopassPoller* instance, uint8_t* key, bool* elite) {
+    if(instance->num_pending_keys == 0) return false;
+    memcpy(key, instance->pending_keys[0].key, PICOPASS_KEY_LEN);
+    *elite = instance->pending_keys[0].is_elite_key;
+    instance->num_pending_keys--;
+    memmove(
+        &instance->pending_keys[0],
+        &instance->pending_keys[1],
+        instance->num_pending_keys * sizeof(PicopassPollerKey));
+    return true;
+}
+
+static NfcCommand
+    picopass_poller_return_key(PicopassPoller* instance, const uint8_t* key, bool elite) {
+    instance->event.type = PicopassPollerEventTypeReturnKey;
+    memcpy(instance->event_data.req_key.key, key, PICOPASS_KEY_LEN);
+    instance->event_data.req_key.is_elite_key = elite;
+    instance->event_data.req_key.is_key_provided = true;
+    return instance->callback(instance->event, instance->context);
+}
+
+// Hands every key the card never checked back to the scene, pending ones first
+static void picopass_poller_return_keys(PicopassPoller* instance) {
+    uint8_t key[PICOPASS_KEY_LEN];
+    bool elite = false;
+    while(picopass_poller_pop_pending_key(instance, key, &elite)) {
+        picopass_poller_return_key(instance, key, elite);
+    }
+    if(instance->prefetch_pending) {
+        picopass_poller_prefetch_drop(instance);
+        picopass_poller_return_key(
+            instance, instance->prefetch.key, instance->prefetch.is_elite_key);
+    }
+}
+
+// Keys taken for one card are not tried on the next, the scene may be keeping track per card
+static void picopass_poller_check_keys_csn(PicopassPoller* instance) {
+    const uint8_t* csn = instance->serial_num.data;
+    if((instance->num_pending_keys > 0 &&
+        memcmp(instance->pending_csn, csn, PICOPASS_BLOCK_LEN) != 0) ||
+       (instance->prefetch_pending &&
+        memcmp(instance->prefetch.csn, csn, PICOPASS_BLOCK_LEN) != 0)) {
+        picopass_poller_return_keys(instance);
+    }
+}
+
+// Div keys precomputed for this CSN, looked up once per card rather than once per detection
+static void picopass_poller_load_div_table(PicopassPoller* instance) {
+    const uint8_t* csn = instance->serial_num.data;
+    if(instance->div_table_checked &&
+       memcmp(instance->div_table_csn, csn, PICOPASS_BLOCK_LEN) == 0) {
+        return;
+    }
+
+    picopass_poller_prefetch_sync(instance);
+    if(instance->div_table) {
+        iclass_div_table_free(instance->div_table);
+    }
+    instance->div_table = iclass_div_table_alloc(csn);
+    memcpy(instance->div_table_csn, csn, PICOPASS_BLOCK_LEN);
+    instance->div_table_checked = true;
+}
+
+// The card family's calibrated timing, or the scene's when it has none or just failed on it
+static void picopass_poller_select_timing(PicopassPoller* instance) {
+    PicopassPollerTiming timing = instance->timing;
+    instance->calibrated_active =
+        !instance->calibrated_skip &&
+        iclass_timing_lookup(instance->calibrated, instance->serial_num.data, &timing);
+    instance->calibrated_skip = false;
+    if(instance->calibrated_active) {
+        FURI_LOG_D(
+            TAG,
+            "Calibrated timing: guard %lu us fdt %lu fc poll %lu us",
+            timing.guard_time_us,
+            timing.fdt_poll_fc,
+            timing.fdt_poll_poll_us);
+    }
+    picopass_poller_apply_timing(instance, &timing);
 }
 
 static void picopass_poller_prepare_read(PicopassPoller* instance) {
@@ -22,35 +299,244 @@ static void picopass_poller_prepare_read(PicopassPoller* instance) {
     instance->current_block = 2;
 }
 
+static bool picopass_poller_delta_active(PicopassPoller* instance) {
+    return instance->reference && !instance->batch;
+}
+
+static void picopass_poller_delta_record(PicopassPoller* instance, uint8_t block_num) {
+    const PicopassBlock* reference = &instance->reference->card_data[block_num];
+    uint32_t bit = 1UL << block_num;
+
+    bool unchanged =
+        reference->valid &&
+        memcmp(reference->data, instance->data->card_data[block_num].data, PICOPASS_BLOCK_LEN) ==
+            0;
+    instance->delta.read |= bit;
+    if(!unchanged) instance->delta.changed |= bit;
+}
+
+// The header was just read. On the reference card everything else starts out as saved, and only
+// the credential and whatever the save is missing are read again.
+static void picopass_poller_delta_prepare(PicopassPoller* instance) {
+    const PicopassBlock* reference = instance->reference->card_data;
+    PicopassBlock* card_data = instance->data->card_data;
+
+    memset(&instance->delta, 0, sizeof(PicopassPollerDelta));
+    for(size_t i = 0; i < PICOPASS_MAX_APP_LIMIT; i++) {
+        if(PICOPASS_POLLER_DELTA_HEADER_BLOCKS & (1UL << i)) {
+            picopass_poller_delta_record(instance, i);
+        }
+    }
+    uint32_t identity = (1UL << PICOPASS_CSN_BLOCK_INDEX) | (1UL << PICOPASS_CONFIG_BLOCK_INDEX);
+    instance->delta.same_card = (instance->delta.changed & identity) == 0;
+
+    instance->delta_blocks = PICOPASS_POLLER_DELTA_VOLATILE_BLOCKS;
+    for(size_t i = 0; i < PICOPASS_MAX_APP_LIMIT; i++) {
+        if(PICOPASS_POLLER_DELTA_HEADER_BLOCKS & (1UL << i)) continue;
+        if(instance->delta.same_card) {
+            card_data[i] = reference[i];
+            if(!reference[i].valid) instance->delta_blocks |= 1UL << i;
+        } else {
+            memset(&card_data[i], 0, sizeof(PicopassBlock));
+        }
+    }
+    if(!instance->delta.same_card) {
+        FURI_LOG_D(TAG, "Not the reference card, reading it in full");
+        instance->delta.full = true;
+        instance->delta_blocks = UINT32_MAX;
+    }
+}
+
+// Anything but the epurse changing means the card was written to since it was saved, so the
+// blocks skipped so far may have changed as well
+static bool picopass_poller_delta_escalate(PicopassPoller* instance) {
+    uint32_t written = instance->delta.changed & ~(1UL << PICOPASS_SECURE_EPURSE_BLOCK_INDEX);
+    if(instance->delta.full || written == 0) return false;
+
+    FURI_LOG_D(TAG, "Blocks %08lx changed, reading the rest", written);
+    instance->delta.full = true;
+    instance->delta_blocks = ~instance->delta.read;
+    picopass_poller_prepare_read(instance);
+    return true;
+}
+
 NfcCommand picopass_poller_request_mode_handler(PicopassPoller* instance) {
     NfcCommand command = NfcCommandContinue;
 
     instance->event.type = PicopassPollerEventTypeRequestMode;
+    instance->event_data.req_mode.batch = false;
     command = instance->callback(instance->event, instance->context);
     instance->mode = instance->event_data.req_mode.mode;
+    instance->batch = instance->mode == PicopassPollerModeRead &&
+                      instance->event_data.req_mode.batch;
+    if(instance->mode == PicopassPollerModeRead && !instance->calibrated) {
+        instance->calibrated = iclass_timing_alloc();
+    }
     instance->state = PicopassPollerStateDetect;
 
     return command;
 }
 
+// A card that just went away is usually back within moments, an empty field is polled less often
+static uint32_t picopass_poller_detect_delay(PicopassPoller* instance) {
+    const PicopassPollerDetectConfig* config = &instance->detect_config;
+    if(instance->detect_misses <= config->fast_attempts) return config->fast_delay_ms;
+
+    uint32_t delay = MAX(config->fast_delay_ms, 1UL);
+    for(uint32_t i = config->fast_attempts; i < instance->detect_misses; i++) {
+        delay *= 2;
+        if(delay >= config->idle_delay_ms) return config->idle_delay_ms;
+    }
+    return delay;
+}
+
+static void picopass_poller_detect_record(PicopassPoller* instance) {
+    uint32_t latency = furi_get_tick() - instance->detect_start_tick;
+    size_t bucket = 0;
+    while(bucket < PICOPASS_POLLER_DETECT_LATENCY_BUCKETS - 1 && (latency >> bucket) != 0) {
+        bucket++;
+    }
+    instance->stats.detect_latency[bucket]++;
+    FURI_LOG_D(TAG, "Detected after %lu ms, %lu misses", latency, instance->detect_misses);
+}
+
 NfcCommand picopass_poller_detect_handler(PicopassPoller* instance) {
     NfcCommand command = NfcCommandContinue;
+
+    if(instance->detect_misses == 0) instance->detect_start_tick = furi_get_tick();
     PicopassError error = picopass_poller_actall(instance);
 
     if(error == PicopassErrorNone) {
-        instance->state = PicopassPollerStateSelect;
+        picopass_poller_detect_record(instance);
+        instance->detect_misses = 0;
+        instance->state = instance->batch ? PicopassPollerStateEnumerate :
+                                            PicopassPollerStateSelect;
         instance->event.type = PicopassPollerEventTypeCardDetected;
         command = instance->callback(instance->event, instance->context);
     } else {
-        furi_delay_ms(100);
+        instance->detect_misses++;
+        furi_delay_ms(picopass_poller_detect_delay(instance));
+    }
+
+    return command;
+}
+
+// A batch moves on to its next card rather than detecting the lost one again
+static PicopassPollerState picopass_poller_card_lost_state(PicopassPoller* instance) {
+    return instance->batch ? PicopassPollerStateFail : PicopassPollerStateDetect;
+}
+
+static bool picopass_poller_batch_contains(PicopassPoller* instance, const uint8_t* csn) {
+    for(size_t i = 0; i < instance->batch_count; i++) {
+        if(memcmp(instance->batch_cards[i].serial_num.data, csn, PICOPASS_BLOCK_LEN) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ACTALL in detect woke every card in the field. Whichever card IDENTIFY gets a clean answer from
+// is selected, queued and halted so the next round only hears the others. The NFC stack hands
+// over whole frames, so cards answering together show up as a CRC error with no collision bits
+// to split them on, another round usually lets the stronger one through.
+NfcCommand picopass_poller_enumerate_handler(PicopassPoller* instance) {
+    NfcCommand command = NfcCommandContinue;
+
+    instance->batch_count = 0;
+    instance->batch_index = 0;
+    size_t collisions = 0;
+    while(instance->batch_count < PICOPASS_POLLER_BATCH_MAX_CARDS) {
+        PicopassPollerBatchCard* card = &instance->batch_cards[instance->batch_count];
+        PicopassError error = picopass_poller_identify(instance, &card->col_res_serial_num);
+        if(error == PicopassErrorNone) {
+            error = picopass_poller_select(instance, &card->col_res_serial_num, &card->serial_num);
+        }
+        if(error == PicopassErrorIncorrectCrc &&
+           collisions < PICOPASS_POLLER_BATCH_MAX_COLLISIONS) {
+            collisions++;
+        } else if(error != PicopassErrorNone) {
+            break;
+        } else if(picopass_poller_batch_contains(instance, card->serial_num.data)) {
+            // It ignored HALT and would keep answering first
+            FURI_LOG_W(TAG, "Card answered again after HALT");
+            break;
+        } else {
+            instance->batch_count++;
+            picopass_poller_halt(instance);
+        }
+        if(picopass_poller_actall(instance) != PicopassErrorNone) break;
+    }
+    FURI_LOG_I(TAG, "Batch of %zu cards, %zu collisions", instance->batch_count, collisions);
+
+    if(instance->batch_count == 0) {
+        instance->state = PicopassPollerStateDetect;
+    } else {
+        instance->event.type = PicopassPollerEventTypeBatchDetected;
+        instance->event_data.batch.index = 0;
+        instance->event_data.batch.count = instance->batch_count;
+        command = instance->callback(instance->event, instance->context);
+        instance->state = PicopassPollerStateSelect;
+    }
+
+    return command;
+}
+
+// Wakes the queued cards and selects the next one by its anticollision CSN
+static NfcCommand picopass_poller_batch_select(PicopassPoller* instance) {
+    NfcCommand command = NfcCommandContinue;
+
+    if(instance->batch_index == instance->batch_count) {
+        instance->event.type = PicopassPollerEventTypeBatchDone;
+        instance->event_data.batch.index = instance->batch_index;
+        instance->event_data.batch.count = instance->batch_count;
+        command = instance->callback(instance->event, instance->context);
+        instance->batch_count = 0;
+        instance->state = PicopassPollerStateDetect;
+        return command;
+    }
+
+    PicopassPollerBatchCard* card = &instance->batch_cards[instance->batch_index];
+    PicopassError error = picopass_poller_act(instance);
+    if(error == PicopassErrorNone) {
+        error = picopass_poller_select(instance, &card->col_res_serial_num, &instance->serial_num);
+    }
+    if(error == PicopassErrorNone &&
+       memcmp(instance->serial_num.data, card->serial_num.data, PICOPASS_BLOCK_LEN) == 0) {
+        instance->state = PicopassPollerStatePreAuth;
+    } else {
+        FURI_LOG_W(TAG, "Batch card %zu not selected: %d", instance->batch_index, error);
+        memcpy(instance->serial_num.data, card->serial_num.data, PICOPASS_BLOCK_LEN);
+        instance->state = PicopassPollerStateFail;
     }
 
     return command;
 }
 
+// Hands the card over, puts it back to sleep and moves on without going through detect
+static NfcCommand picopass_poller_batch_next(PicopassPoller* instance, bool complete) {
+    instance->event.type = PicopassPollerEventTypeCardRead;
+    instance->event_data.batch.index = instance->batch_index;
+    instance->event_data.batch.count = instance->batch_count;
+    instance->event_data.batch.complete = complete;
+    NfcCommand command = instance->callback(instance->event, instance->context);
+
+    picopass_poller_halt(instance);
+    memset(instance->data, 0, sizeof(PicopassDeviceData));
+    picopass_poller_reset(instance);
+    // The scene starts the next card over from its first key
+    instance->num_pending_keys = 0;
+    picopass_poller_prefetch_drop(instance);
+    instance->batch_index++;
+    instance->state = PicopassPollerStateSelect;
+
+    return command;
+}
+
 NfcCommand picopass_poller_select_handler(PicopassPoller* instance) {
     NfcCommand command = NfcCommandContinue;
 
+    if(instance->batch) return picopass_poller_batch_select(instance);
+
     do {
         PicopassError error = picopass_poller_identify(instance, &instance->col_res_serial_num);
         if(error != PicopassErrorNone) {
@@ -65,7 +551,9 @@ NfcCommand picopass_poller_select_handler(PicopassPoller* instance) {
             break;
         }
 
-        instance->state = PicopassPollerStatePreAuth;
+        instance->state = instance->mode == PicopassPollerModeCalibrate ?
+                              PicopassPollerStateCalibrate :
+                              PicopassPollerStatePreAuth;
     } while(false);
 
     return command;
@@ -107,49 +595,59 @@ NfcCommand picopass_poller_pre_auth_handler(PicopassPoller* instance) {
         picopass_poller_print_block(
             "csn %02x%02x%02x%02x%02x%02x%02x%02x",
             instance->data->card_data[PICOPASS_CSN_BLOCK_INDEX]);
+        if(instance->mode == PicopassPollerModeRead) {
+            picopass_poller_check_keys_csn(instance);
+            picopass_poller_select_timing(instance);
+            picopass_poller_load_div_table(instance);
+        }
 
-        PicopassBlock block = {};
-        error = picopass_poller_read_block(instance, PICOPASS_CONFIG_BLOCK_INDEX, &block);
+        // Config through Kc in one exchange, straight into card_data. Kd and Kc read as FF until
+        // authenticated so they stay invalid. Without READ4 config and epurse are read one by one.
+        PicopassBlock* card_data = instance->data->card_data;
+        error = picopass_poller_read4(
+            instance, PICOPASS_CONFIG_BLOCK_INDEX, &card_data[PICOPASS_CONFIG_BLOCK_INDEX]);
         if(error != PicopassErrorNone) {
-            instance->state = PicopassPollerStateFail;
-            break;
+            instance->read4_failed = true;
+            error = picopass_poller_read_block(
+                instance, PICOPASS_CONFIG_BLOCK_INDEX, &card_data[PICOPASS_CONFIG_BLOCK_INDEX]);
+            if(error == PicopassErrorNone) {
+                error = picopass_poller_read_block(
+                    instance,
+                    PICOPASS_SECURE_EPURSE_BLOCK_INDEX,
+                    &card_data[PICOPASS_SECURE_EPURSE_BLOCK_INDEX]);
+            }
         }
-        memcpy(
-            instance->data->card_data[PICOPASS_CONFIG_BLOCK_INDEX].data,
-            block.data,
-            PICOPASS_BLOCK_LEN);
-        instance->data->card_data[PICOPASS_CONFIG_BLOCK_INDEX].valid = true;
-        picopass_poller_print_block(
-            "config %02x%02x%02x%02x%02x%02x%02x%02x",
-            instance->data->card_data[PICOPASS_CONFIG_BLOCK_INDEX]);
-
-        error = picopass_poller_read_block(instance, PICOPASS_SECURE_EPURSE_BLOCK_INDEX, &block);
         if(error != PicopassErrorNone) {
             instance->state = PicopassPollerStateFail;
             break;
         }
+        card_data[PICOPASS_CONFIG_BLOCK_INDEX].valid = true;
+        card_data[PICOPASS_SECURE_EPURSE_BLOCK_INDEX].valid = true;
         memcpy(
-            instance->data->card_data[PICOPASS_SECURE_EPURSE_BLOCK_INDEX].data,
-            block.data,
+            instance->expected_cc,
+            card_data[PICOPASS_SECURE_EPURSE_BLOCK_INDEX].data,
             PICOPASS_BLOCK_LEN);
-        instance->data->card_data[PICOPASS_SECURE_EPURSE_BLOCK_INDEX].valid = true;
+        picopass_poller_print_block(
+            "config %02x%02x%02x%02x%02x%02x%02x%02x", card_data[PICOPASS_CONFIG_BLOCK_INDEX]);
         picopass_poller_print_block(
             "epurse %02x%02x%02x%02x%02x%02x%02x%02x",
-            instance->data->card_data[PICOPASS_SECURE_EPURSE_BLOCK_INDEX]);
+            card_data[PICOPASS_SECURE_EPURSE_BLOCK_INDEX]);
 
-        error = picopass_poller_read_block(instance, PICOPASS_SECURE_AIA_BLOCK_INDEX, &block);
+        error = picopass_poller_read_block(
+            instance,
+            PICOPASS_SECURE_AIA_BLOCK_INDEX,
+            &card_data[PICOPASS_SECURE_AIA_BLOCK_INDEX]);
         if(error != PicopassErrorNone) {
             instance->state = PicopassPollerStateFail;
             break;
         }
-        memcpy(
-            instance->data->card_data[PICOPASS_SECURE_AIA_BLOCK_INDEX].data,
-            block.data,
-            PICOPASS_BLOCK_LEN);
-        instance->data->card_data[PICOPASS_SECURE_AIA_BLOCK_INDEX].valid = true;
+        card_data[PICOPASS_SECURE_AIA_BLOCK_INDEX].valid = true;
         picopass_poller_print_block(
-            "aia %02x%02x%02x%02x%02x%02x%02x%02x",
-            instance->data->card_data[PICOPASS_SECURE_AIA_BLOCK_INDEX]);
+            "aia %02x%02x%02x%02x%02x%02x%02x%02x", card_data[PICOPASS_SECURE_AIA_BLOCK_INDEX]);
+
+        if(picopass_poller_delta_active(instance)) {
+            picopass_poller_delta_prepare(instance);
+        }
 
         instance->state = PicopassPollerStateCheckSecurity;
     } while(false);
@@ -227,7 +725,6 @@ NfcCommand picopass_poller_nr_mac_auth(PicopassPoller* instance) {
     FuriString* temp_str = furi_string_alloc();
     FuriString* filename = furi_string_alloc();
     FlipperFormat* file = flipper_format_file_alloc(dev->storage);
-    PicopassMac mac = {};
 
     for(size_t i = 0; i < PICOPASS_BLOCK_LEN; i++) {
         furi_string_cat_printf(filename, "%02x", csn[i]);
@@ -241,9 +738,13 @@ NfcCommand picopass_poller_nr_mac_auth(PicopassPoller* instance) {
         temp_str, "%s/%s%s", STORAGE_APP_DATA_PATH_PREFIX, furi_string_get_cstr(filename), ".mac");
 
     FURI_LOG_D(TAG, "Looking for %s", furi_string_get_cstr(temp_str));
-    uint8_t nr_mac[PICOPASS_BLOCK_LEN];
 
-    // Set next state so breaking do/while will jump to it. If successful, do/while will set to ReadBlock
+    // A key matched offline before the card was lost is only kept if the NR-MAC is found again
+    bool resume_offline_key = instance->offline_key_found;
+    instance->offline_key_found = false;
+
+    // Set next state so breaking do/while will jump to it.
+    // If a .mac file is loaded, do/while will set to OfflineAuth
     if(instance->data->pacs.se_enabled) {
         instance->state = PicopassPollerStateAuthFail;
     } else {
@@ -257,56 +758,135 @@ NfcCommand picopass_poller_nr_mac_auth(PicopassPoller* instance) {
 
         furi_string_printf(temp_str, "NR-MAC");
         if(!flipper_format_read_hex(
-               file, furi_string_get_cstr(temp_str), nr_mac, PICOPASS_BLOCK_LEN))
+               file, furi_string_get_cstr(temp_str), instance->nr_mac, PICOPASS_BLOCK_LEN))
             break;
-        memcpy(mac.data, nr_mac + 4, PICOPASS_MAC_LEN);
         /*
         FURI_LOG_D(
             TAG,
             "Read nr-mac: %02x %02x %02x %02x %02x %02x %02x %02x",
-            nr_mac[0],
-            nr_mac[1],
-            nr_mac[2],
-            nr_mac[3],
-            nr_mac[4],
-            nr_mac[5],
-            nr_mac[6],
-            nr_mac[7]);
-        FURI_LOG_D(
-            TAG, "MAC: %02x %02x %02x %02x", mac.data[0], mac.data[1], mac.data[2], mac.data[3]);
+            instance->nr_mac[0],
+            instance->nr_mac[1],
+            instance->nr_mac[2],
+            instance->nr_mac[3],
+            instance->nr_mac[4],
+            instance->nr_mac[5],
+            instance->nr_mac[6],
+            instance->nr_mac[7]);
         */
 
-        uint8_t ccnr[12] = {};
+        if(resume_offline_key) {
+            instance->offline_key_found = true;
+            instance->state = PicopassPollerStateAuth;
+        } else {
+            // The captured NR-MAC lets us test keys without talking to the card
+            instance->state = PicopassPollerStateNrMacOfflineAuth;
+        }
+    } while(false);
+    furi_string_free(temp_str);
+    furi_string_free(filename);
+    flipper_format_free(file);
+
+    return command;
+}
+
+NfcCommand picopass_poller_nr_mac_offline_auth_handler(PicopassPoller* instance) {
+    NfcCommand command = NfcCommandContinue;
+
+    uint8_t* epurse = instance->data->card_data[PICOPASS_SECURE_EPURSE_BLOCK_INDEX].data;
+
+    // The reader MAC in the file was computed over CC (epurse) and the captured NR
+    uint8_t ccnr[12] = {};
+    memcpy(ccnr, epurse, PICOPASS_BLOCK_LEN);
+    memcpy(ccnr + PICOPASS_BLOCK_LEN, instance->nr_mac, 4);
+
+    uint8_t keys[PICOPASS_POLLER_OFFLINE_KEY_BATCH][PICOPASS_KEY_LEN];
+    bool is_elite_key[PICOPASS_POLLER_OFFLINE_KEY_BATCH];
+    uint8_t div_keys[PICOPASS_POLLER_OFFLINE_KEY_BATCH * PICOPASS_KEY_LEN];
+    size_t num_keys = 0;
+    bool dict_exhausted = false;
+
+    // Keys taken before the card was lost were never checked, they go first
+    while(num_keys < PICOPASS_POLLER_OFFLINE_KEY_BATCH) {
+        uint8_t* div_key = div_keys + num_keys * PICOPASS_KEY_LEN;
+        if(picopass_poller_pop_pending_key(instance, keys[num_keys], &is_elite_key[num_keys])) {
+            picopass_poller_calc_div_key(
+                instance, keys[num_keys], div_key, is_elite_key[num_keys]);
+        } else if(instance->prefetch_pending) {
+            picopass_poller_prefetch_drop(instance);
+            memcpy(keys[num_keys], instance->prefetch.key, PICOPASS_KEY_LEN);
+            is_elite_key[num_keys] = instance->prefetch.is_elite_key;
+            memcpy(div_key, instance->prefetch.div_key, PICOPASS_KEY_LEN);
+        } else {
+            instance->event.type = PicopassPollerEventTypeRequestKey;
+            command = instance->callback(instance->event, instance->context);
+            if(command != NfcCommandContinue) return command;
+
+            if(!instance->event_data.req_key.is_key_provided) {
+                dict_exhausted = true;
+                break;
+            }
+
+            memcpy(keys[num_keys], instance->event_data.req_key.key, PICOPASS_KEY_LEN);
+            is_elite_key[num_keys] = instance->event_data.req_key.is_elite_key;
+            picopass_poller_calc_div_key(
+                instance, keys[num_keys], div_key, is_elite_key[num_keys]);
+        }
+        num_keys++;
+    }
+
+    LoclassLanes_t match = 0;
+    if(num_keys > 0) {
+        match = loclass_opt_checkReaderMAC_multi(ccnr, div_keys, num_keys, instance->nr_mac + 4);
+    }
+
+    for(size_t i = 0; i < num_keys; i++) {
+        if(((match >> i) & 1) == 0) continue;
+
+        FURI_LOG_I(TAG, "Found key offline, confirming with card");
+        // Hand the matching key to auth in place of requesting another one
+        memcpy(instance->event_data.req_key.key, keys[i], PICOPASS_KEY_LEN);
+        instance->event_data.req_key.is_elite_key = is_elite_key[i];
+        instance->event_data.req_key.is_key_provided = true;
+        instance->offline_key_found = true;
+        instance->state = PicopassPollerStateAuth;
+        // The rest of the batch is only ruled out if the card takes this key, keep it until then
+        for(size_t j = i + 1; j < num_keys; j++) {
+            picopass_poller_push_pending_key(instance, keys[j], is_elite_key[j]);
+        }
+        return command;
+    }
+
+    if(dict_exhausted) {
+        FURI_LOG_D(TAG, "No key matched NR-MAC offline, replaying it");
+        instance->state = PicopassPollerStateNrMacReplay;
+    }
+
+    return command;
+}
+
+NfcCommand picopass_poller_nr_mac_replay_handler(PicopassPoller* instance) {
+    NfcCommand command = NfcCommandContinue;
+    PicopassMac mac = {};
+    memcpy(mac.data, instance->nr_mac + 4, PICOPASS_MAC_LEN);
+
+    // Every dictionary key was already ruled out offline, so a failed replay ends the attempt
+    instance->state = PicopassPollerStateAuthFail;
+    do {
         PicopassReadCheckResp read_check_resp = {};
         PicopassError error = picopass_poller_read_check(instance, &read_check_resp);
         if(error == PicopassErrorTimeout) {
             instance->event.type = PicopassPollerEventTypeCardLost;
             instance->callback(instance->event, instance->context);
-            instance->state = PicopassPollerStateDetect;
+            instance->state = picopass_poller_card_lost_state(instance);
             break;
         } else if(error != PicopassErrorNone) {
             FURI_LOG_E(TAG, "Read check failed: %d", error);
             break;
         }
-        memcpy(ccnr, read_check_resp.data, sizeof(PicopassReadCheckResp)); // last 4 bytes left 0
-
-        /*
-        FURI_LOG_D(
-            TAG,
-            "CCNR: %02x %02x %02x %02x %02x %02x %02x %02x",
-            ccnr[0],
-            ccnr[1],
-            ccnr[2],
-            ccnr[3],
-            ccnr[4],
-            ccnr[5],
-            ccnr[6],
-            ccnr[7]);
-            */
 
         //use mac
         PicopassCheckResp check_resp = {};
-        error = picopass_poller_check(instance, nr_mac, &mac, &check_resp);
+        error = picopass_poller_check(instance, instance->nr_mac, &mac, &check_resp);
         if(error == PicopassErrorNone) {
             instance->data->auth = PicopassDeviceAuthMethodNrMac;
             memcpy(instance->mac.data, mac.data, sizeof(PicopassMac));
@@ -315,44 +895,23 @@ NfcCommand picopass_poller_nr_mac_auth(PicopassPoller* instance) {
                 instance->state = PicopassPollerStateReadBlock;
             }
         }
-
     } while(false);
-    furi_string_free(temp_str);
-    furi_string_free(filename);
-    flipper_format_free(file);
 
     return command;
 }
 
 NfcCommand picopass_poller_auth_handler(PicopassPoller* instance) {
     NfcCommand command = NfcCommandContinue;
+    // Reading runs through dictionaries, so the next key is diversified while this one is on air.
+    // Writes only ever get the one key they were given.
+    bool pipelined = instance->mode == PicopassPollerModeRead && !instance->offline_key_found;
 
     do {
-        // Request key
-        instance->event.type = PicopassPollerEventTypeRequestKey;
-        command = instance->callback(instance->event, instance->context);
-        if(command != NfcCommandContinue) break;
-
-        if(!instance->event_data.req_key.is_key_provided) {
-            instance->state = PicopassPollerStateAuthFail;
-            break;
-        }
-
-        FURI_LOG_D(
-            TAG,
-            "Try to %s auth with key %02x%02x%02x%02x%02x%02x%02x%02x",
-            instance->event_data.req_key.is_elite_key ? "elite" : "standard",
-            instance->event_data.req_key.key[0],
-            instance->event_data.req_key.key[1],
-            instance->event_data.req_key.key[2],
-            instance->event_data.req_key.key[3],
-            instance->event_data.req_key.key[4],
-            instance->event_data.req_key.key[5],
-            instance->event_data.req_key.key[6],
-            instance->event_data.req_key.key[7]);
-
-        PicopassReadCheckResp read_check_resp = {};
-        uint8_t* csn = instance->serial_num.data;
+        uint8_t key[PICOPASS_KEY_LEN] = {};
+        bool is_elite_key = false;
+        bool div_key_ready = false;
+        uint8_t precomputed_cc[PICOPASS_BLOCK_LEN] = {};
+        PicopassMac precomputed_mac = {};
         memset(instance->div_key, 0, sizeof(instance->div_key));
         uint8_t* div_key = NULL;
 
@@ -362,39 +921,105 @@ NfcCommand picopass_poller_auth_handler(PicopassPoller* instance) {
             div_key = instance->div_key;
         }
 
+        // Matched against a captured NR-MAC, it goes before anything taken from the dictionary
+        bool offline_key = instance->offline_key_found;
+        if(offline_key) {
+            memcpy(key, instance->event_data.req_key.key, PICOPASS_KEY_LEN);
+            is_elite_key = instance->event_data.req_key.is_elite_key;
+        } else if(instance->num_pending_keys > 0) {
+            picopass_poller_pop_pending_key(instance, key, &is_elite_key);
+        } else if(pipelined && instance->prefetch_pending) {
+            div_key_ready = picopass_poller_take_prefetched_key(
+                instance, key, &is_elite_key, div_key, precomputed_cc, &precomputed_mac);
+        } else {
+            // Request key
+            instance->event.type = PicopassPollerEventTypeRequestKey;
+            command = instance->callback(instance->event, instance->context);
+            if(command != NfcCommandContinue) break;
+
+            if(!instance->event_data.req_key.is_key_provided) {
+                FURI_LOG_D(
+                    TAG,
+                    "MACs precomputed %lu, computed %lu",
+                    instance->stats.mac_precomputed,
+                    instance->stats.mac_computed);
+                instance->state = PicopassPollerStateAuthFail;
+                break;
+            }
+            memcpy(key, instance->event_data.req_key.key, PICOPASS_KEY_LEN);
+            is_elite_key = instance->event_data.req_key.is_elite_key;
+        }
+
+        if(pipelined && !instance->prefetch_pending) {
+            command = picopass_poller_prefetch_key(instance);
+            if(command != NfcCommandContinue) break;
+        }
+
+        FURI_LOG_D(
+            TAG,
+            "Try to %s auth with key %02x%02x%02x%02x%02x%02x%02x%02x",
+            is_elite_key ? "elite" : "standard",
+            key[0],
+            key[1],
+            key[2],
+            key[3],
+            key[4],
+            key[5],
+            key[6],
+            key[7]);
+
+        PicopassReadCheckResp read_check_resp = {};
         uint8_t ccnr[12] = {};
         PicopassMac mac = {};
 
         PicopassError error = picopass_poller_read_check(instance, &read_check_resp);
+        if(error != PicopassErrorNone && pipelined) {
+            // The next key is already taken from the dictionary, this one was never checked
+            picopass_poller_push_pending_key(instance, key, is_elite_key);
+        }
         if(error == PicopassErrorTimeout) {
             instance->event.type = PicopassPollerEventTypeCardLost;
             command = instance->callback(instance->event, instance->context);
-            instance->state = PicopassPollerStateDetect;
+            instance->state = picopass_poller_card_lost_state(instance);
             break;
         } else if(error != PicopassErrorNone) {
             FURI_LOG_E(TAG, "Read check failed: %d", error);
             break;
         }
         memcpy(ccnr, read_check_resp.data, sizeof(PicopassReadCheckResp)); // last 4 bytes left 0
-
-        loclass_iclass_calc_div_key(
-            csn,
-            instance->event_data.req_key.key,
-            div_key,
-            instance->event_data.req_key.is_elite_key);
-        loclass_opt_doReaderMAC(ccnr, div_key, mac.data);
+        memcpy(instance->expected_cc, read_check_resp.data, PICOPASS_BLOCK_LEN);
+
+        // The CC is the epurse, it only changes when the card is debited, so the MAC made
+        // ahead of time almost always holds and CHECK follows READCHECK without any crypto
+        if(div_key_ready &&
+           memcmp(precomputed_cc, read_check_resp.data, PICOPASS_BLOCK_LEN) == 0) {
+            mac = precomputed_mac;
+            instance->stats.mac_precomputed++;
+        } else {
+            if(!div_key_ready) picopass_poller_calc_div_key(instance, key, div_key, is_elite_key);
+            uint32_t start = picopass_poller_cycles();
+            loclass_opt_doReaderMAC(ccnr, div_key, mac.data);
+            instance->stats.mac_cycles += picopass_poller_cycles() - start;
+            instance->stats.mac_computed++;
+        }
+        instance->stats.keys_tried++;
 
         PicopassCheckResp check_resp = {};
         error = picopass_poller_check(instance, NULL, &mac, &check_resp);
+        // Key matched against a captured NR-MAC has now been confirmed or rejected by the card
+        if(offline_key) instance->offline_key_found = false;
         if(error == PicopassErrorNone) {
-            FURI_LOG_I(TAG, "Found key");
+            FURI_LOG_I(
+                TAG,
+                "Found key, MACs precomputed %lu, computed %lu",
+                instance->stats.mac_precomputed,
+                instance->stats.mac_computed);
             instance->data->auth = PicopassDeviceAuthMethodKey;
             memcpy(instance->mac.data, mac.data, sizeof(PicopassMac));
             if(instance->mode == PicopassPollerModeRead) {
-                memcpy(
-                    instance->data->pacs.key, instance->event_data.req_key.key, PICOPASS_KEY_LEN);
+                memcpy(instance->data->pacs.key, key, PICOPASS_KEY_LEN);
                 instance->data->card_data[PICOPASS_SECURE_KD_BLOCK_INDEX].valid = true;
-                instance->data->pacs.elite_kdf = instance->event_data.req_key.is_elite_key;
+                instance->data->pacs.elite_kdf = is_elite_key;
                 picopass_poller_prepare_read(instance);
                 instance->state = PicopassPollerStateReadBlock;
             } else if(instance->mode == PicopassPollerModeWrite) {
@@ -409,10 +1034,71 @@ NfcCommand picopass_poller_auth_handler(PicopassPoller* instance) {
     return command;
 }
 
+static bool picopass_poller_is_key_block(PicopassPoller* instance, uint8_t block_num) {
+    return instance->secured && (block_num == PICOPASS_SECURE_KD_BLOCK_INDEX ||
+                                 block_num == PICOPASS_SECURE_KC_BLOCK_INDEX);
+}
+
+static void picopass_poller_store_block(PicopassPoller* instance, const PicopassBlock* block) {
+    FURI_LOG_D(
+        TAG,
+        "Block %d: %02x%02x%02x%02x%02x%02x%02x%02x",
+        instance->current_block,
+        block->data[0],
+        block->data[1],
+        block->data[2],
+        block->data[3],
+        block->data[4],
+        block->data[5],
+        block->data[6],
+        block->data[7]);
+    memcpy(
+        instance->data->card_data[instance->current_block].data, block->data, PICOPASS_BLOCK_LEN);
+    instance->data->card_data[instance->current_block].valid = true;
+    if(picopass_poller_delta_active(instance)) {
+        picopass_poller_delta_record(instance, instance->current_block);
+    }
+    instance->current_block++;
+}
+
+// Four blocks in one exchange while a whole window is left that skips the key blocks
+static bool picopass_poller_read4_blocks(PicopassPoller* instance) {
+    uint8_t first = instance->current_block;
+    if(instance->read4_failed || first + PICOPASS_POLLER_READ4_BLOCKS > instance->app_limit) {
+        return false;
+    }
+    for(uint8_t i = first; i < first + PICOPASS_POLLER_READ4_BLOCKS; i++) {
+        if(picopass_poller_is_key_block(instance, i)) return false;
+    }
+
+    PicopassBlock blocks[PICOPASS_POLLER_READ4_BLOCKS] = {};
+    PicopassError error = picopass_poller_read4(instance, first, blocks);
+    if(error != PicopassErrorNone) {
+        FURI_LOG_D(TAG, "READ4 of block %d failed: %d, reading blocks one by one", first, error);
+        instance->read4_failed = true;
+        return false;
+    }
+    for(size_t i = 0; i < PICOPASS_POLLER_READ4_BLOCKS; i++) {
+        picopass_poller_store_block(instance, &blocks[i]);
+    }
+    return true;
+}
+
 NfcCommand picopass_poller_read_block_handler(PicopassPoller* instance) {
     NfcCommand command = NfcCommandContinue;
 
     do {
+        if(picopass_poller_delta_active(instance)) {
+            while(instance->current_block < instance->app_limit &&
+                  !(instance->delta_blocks & (1UL << instance->current_block))) {
+                instance->current_block++;
+            }
+            if(instance->current_block == instance->app_limit &&
+               picopass_poller_delta_escalate(instance)) {
+                break;
+            }
+        }
+
         if(instance->current_block == instance->app_limit) {
             if(instance->secured) {
                 instance->state = PicopassPollerStateParseCredential;
@@ -422,14 +1108,15 @@ NfcCommand picopass_poller_read_block_handler(PicopassPoller* instance) {
             break;
         }
 
-        if(instance->secured && (instance->current_block == PICOPASS_SECURE_KD_BLOCK_INDEX ||
-                                 instance->current_block == PICOPASS_SECURE_KC_BLOCK_INDEX)) {
+        if(picopass_poller_is_key_block(instance, instance->current_block)) {
             // Kd and Kc blocks cannot be read (card always returns FF's)
             // Key blocks we authed as would have been already set earlier
             instance->current_block++;
             continue;
         }
 
+        if(picopass_poller_read4_blocks(instance)) break;
+
         PicopassBlock block = {};
         PicopassError error =
             picopass_poller_read_block(instance, instance->current_block, &block);
@@ -438,24 +1125,7 @@ NfcCommand picopass_poller_read_block_handler(PicopassPoller* instance) {
             instance->state = PicopassPollerStateFail;
             break;
         }
-        FURI_LOG_D(
-            TAG,
-            "Block %d: %02x%02x%02x%02x%02x%02x%02x%02x",
-            instance->current_block,
-            block.data[0],
-            block.data[1],
-            block.data[2],
-            block.data[3],
-            block.data[4],
-            block.data[5],
-            block.data[6],
-            block.data[7]);
-        memcpy(
-            instance->data->card_data[instance->current_block].data,
-            block.data,
-            PICOPASS_BLOCK_LEN);
-        instance->data->card_data[instance->current_block].valid = true;
-        instance->current_block++;
+        picopass_poller_store_block(instance, &block);
     } while(false);
 
     return command;
@@ -531,11 +1201,10 @@ NfcCommand picopass_poller_write_key_handler(PicopassPoller* instance) {
         const uint8_t* new_key = instance->event_data.req_write_key.key;
         bool is_elite_key = instance->event_data.req_write_key.is_elite_key;
 
-        const uint8_t* csn = instance->serial_num.data;
         const uint8_t* old_key = instance->div_key;
 
         PicopassBlock new_block = {};
-        loclass_iclass_calc_div_key(csn, new_key, new_block.data, is_elite_key);
+        picopass_poller_calc_div_key(instance, new_key, new_block.data, is_elite_key);
 
         const uint8_t* config_block = picopass_data->card_data[PICOPASS_CONFIG_BLOCK_INDEX].data;
         uint8_t fuses = config_block[7];
@@ -588,9 +1257,16 @@ NfcCommand picopass_poller_write_key_handler(PicopassPoller* instance) {
 NfcCommand picopass_poller_success_handler(PicopassPoller* instance) {
     NfcCommand command = NfcCommandContinue;
 
-    instance->event.type = PicopassPollerEventTypeSuccess;
-    command = instance->callback(instance->event, instance->context);
-    furi_delay_ms(100);
+    if(instance->batch) return picopass_poller_batch_next(instance, true);
+
+    // Reported once, the poller then idles here until the scene stops it
+    if(!instance->success_reported) {
+        instance->success_reported = true;
+        instance->event.type = PicopassPollerEventTypeSuccess;
+        command = instance->callback(instance->event, instance->context);
+    } else {
+        furi_delay_ms(instance->detect_config.idle_delay_ms);
+    }
 
     return command;
 }
@@ -598,9 +1274,16 @@ NfcCommand picopass_poller_success_handler(PicopassPoller* instance) {
 NfcCommand picopass_poller_fail_handler(PicopassPoller* instance) {
     NfcCommand command = NfcCommandReset;
 
+    // Marginal cards of a calibrated family alternate with the scene's timing
+    instance->calibrated_skip = instance->calibrated_active;
+
+    // A field reset would wake the whole batch up again
+    if(instance->batch) return picopass_poller_batch_next(instance, false);
+
     instance->event.type = PicopassPollerEventTypeFail;
     command = instance->callback(instance->event, instance->context);
     picopass_poller_reset(instance);
+    picopass_poller_apply_timing(instance, &instance->timing);
     instance->state = PicopassPollerStateDetect;
 
     return command;
@@ -609,6 +1292,8 @@ NfcCommand picopass_poller_fail_handler(PicopassPoller* instance) {
 NfcCommand picopass_poller_auth_fail_handler(PicopassPoller* instance) {
     NfcCommand command = NfcCommandReset;
 
+    if(instance->batch) return picopass_poller_batch_next(instance, false);
+
     instance->event.type = PicopassPollerEventTypeAuthFail;
     command = instance->callback(instance->event, instance->context);
     picopass_poller_reset(instance);
@@ -617,13 +1302,111 @@ NfcCommand picopass_poller_auth_fail_handler(PicopassPoller* instance) {
     return command;
 }
 
+static void picopass_poller_calibrate_search(PicopassPoller* instance) {
+    PicopassPollerCalibration* calibration = &instance->calibration;
+    PicopassPollerTiming fast = picopass_poller_timing_profiles[PicopassPollerTimingProfileFast];
+    uint32_t base = *picopass_poller_timing_param(&instance->timing, calibration->param);
+
+    calibration->low = MIN(*picopass_poller_timing_param(&fast, calibration->param), base);
+    calibration->high = base;
+    calibration->probes = 0;
+}
+
+// Wake and select the card being calibrated and read its config block, right after field on
+static bool picopass_poller_calibrate_probe(PicopassPoller* instance) {
+    PicopassColResSerialNum col_res_serial_num = {};
+    PicopassSerialNum serial_num = {};
+    PicopassBlock block = {};
+
+    return picopass_poller_actall(instance) == PicopassErrorNone &&
+           picopass_poller_identify(instance, &col_res_serial_num) == PicopassErrorNone &&
+           picopass_poller_select(instance, &col_res_serial_num, &serial_num) ==
+               PicopassErrorNone &&
+           memcmp(serial_num.data, instance->serial_num.data, sizeof(PicopassSerialNum)) == 0 &&
+           picopass_poller_read_block(instance, PICOPASS_CONFIG_BLOCK_INDEX, &block) ==
+               PicopassErrorNone;
+}
+
+// Guard time, FDT and poll to poll time are searched one after the other, each between the fast
+// profile and the scene's timing. Every value under test is applied on one tick with a field
+// reset, so the guard time counts, and probed on the next.
+NfcCommand picopass_poller_calibrate_handler(PicopassPoller* instance) {
+    NfcCommand command = NfcCommandContinue;
+    PicopassPollerCalibration* calibration = &instance->calibration;
+
+    if(!calibration->started) {
+        memcpy(
+            instance->data->card_data[PICOPASS_CSN_BLOCK_INDEX].data,
+            instance->serial_num.data,
+            sizeof(PicopassSerialNum));
+        instance->data->card_data[PICOPASS_CSN_BLOCK_INDEX].valid = true;
+        calibration->started = true;
+        calibration->param = PicopassPollerTimingParamGuardTime;
+        calibration->timing = instance->timing;
+        picopass_poller_calibrate_search(instance);
+    }
+
+    if(!calibration->armed) {
+        while(calibration->param < PicopassPollerTimingParamNum &&
+              calibration->high - calibration->low <
+                  picopass_poller_calibrate_step[calibration->param]) {
+            // One step above the shortest that answered, for when the card sits a little further
+            uint32_t* value =
+                picopass_poller_timing_param(&calibration->timing, calibration->param);
+            *value = MIN(
+                calibration->high + picopass_poller_calibrate_step[calibration->param],
+                *picopass_poller_timing_param(&instance->timing, calibration->param));
+            FURI_LOG_D(TAG, "Calibrated timing %d to %lu", calibration->param, *value);
+            calibration->param++;
+            if(calibration->param < PicopassPollerTimingParamNum) {
+                picopass_poller_calibrate_search(instance);
+            }
+        }
+        if(calibration->param < PicopassPollerTimingParamNum) {
+            *picopass_poller_timing_param(&calibration->timing, calibration->param) =
+                calibration->low + (calibration->high - calibration->low) / 2;
+        }
+        picopass_poller_apply_timing(instance, &calibration->timing);
+        calibration->armed = true;
+        return NfcCommandReset;
+    }
+
+    calibration->armed = false;
+    bool answered = picopass_poller_calibrate_probe(instance);
+
+    if(calibration->param == PicopassPollerTimingParamNum) {
+        // Everything settled, the whole result gets one last probe before it is handed over
+        if(answered) {
+            instance->event.type = PicopassPollerEventTypeCalibrated;
+            instance->event_data.calibrated.timing = calibration->timing;
+            command = instance->callback(instance->event, instance->context);
+            instance->state = PicopassPollerStateSuccess;
+        } else {
+            instance->state = PicopassPollerStateFail;
+        }
+    } else if(!answered) {
+        calibration->low =
+            *picopass_poller_timing_param(&calibration->timing, calibration->param) + 1;
+        calibration->probes = 0;
+    } else if(++calibration->probes == PICOPASS_POLLER_CALIBRATE_PROBES) {
+        calibration->high =
+            *picopass_poller_timing_param(&calibration->timing, calibration->param);
+        calibration->probes = 0;
+    }
+
+    return command;
+}
+
 static const PicopassPollerStateHandler picopass_poller_state_handler[PicopassPollerStateNum] = {
     [PicopassPollerStateRequestMode] = picopass_poller_request_mode_handler,
     [PicopassPollerStateDetect] = picopass_poller_detect_handler,
     [PicopassPollerStateSelect] = picopass_poller_select_handler,
+    [PicopassPollerStateEnumerate] = picopass_poller_enumerate_handler,
     [PicopassPollerStatePreAuth] = picopass_poller_pre_auth_handler,
     [PicopassPollerStateCheckSecurity] = picopass_poller_check_security,
     [PicopassPollerStateNrMacAuth] = picopass_poller_nr_mac_auth,
+    [PicopassPollerStateNrMacOfflineAuth] = picopass_poller_nr_mac_offline_auth_handler,
+    [PicopassPollerStateNrMacReplay] = picopass_poller_nr_mac_replay_handler,
     [PicopassPollerStateAuth] = picopass_poller_auth_handler,
     [PicopassPollerStateReadBlock] = picopass_poller_read_block_handler,
     [PicopassPollerStateWriteBlock] = picopass_poller_write_block_handler,
@@ -632,6 +1415,7 @@ static const PicopassPollerStateHandler picopass_poller_state_handler[PicopassPo
     [PicopassPollerStateSuccess] = picopass_poller_success_handler,
     [PicopassPollerStateFail] = picopass_poller_fail_handler,
     [PicopassPollerStateAuthFail] = picopass_poller_auth_fail_handler,
+    [PicopassPollerStateCalibrate] = picopass_poller_calibrate_handler,
 };
 
 static NfcCommand picopass_poller_callback(NfcEvent event, void* context) {
@@ -651,6 +1435,48 @@ static NfcCommand picopass_poller_callback(NfcEvent event, void* context) {
     return command;
 }
 
+void picopass_poller_set_detect_config(
+    PicopassPoller* instance,
+    const PicopassPollerDetectConfig* config) {
+    furi_assert(instance);
+    furi_assert(config);
+    furi_assert(instance->session_state == PicopassPollerSessionStateIdle);
+
+    instance->detect_config = *config;
+}
+
+const PicopassPollerTiming*
+    picopass_poller_get_timing_profile(PicopassPollerTimingProfile profile) {
+    furi_assert(profile < PicopassPollerTimingProfileNum);
+
+    return &picopass_poller_timing_profiles[profile];
+}
+
+void picopass_poller_set_timing(PicopassPoller* instance, const PicopassPollerTiming* timing) {
+    furi_assert(instance);
+    furi_assert(timing);
+    furi_assert(instance->session_state == PicopassPollerSessionStateIdle);
+
+    instance->timing = *timing;
+    picopass_poller_apply_timing(instance, timing);
+}
+
+void picopass_poller_get_timing(PicopassPoller* instance, PicopassPollerTiming* timing) {
+    furi_assert(instance);
+    furi_assert(timing);
+
+    *timing = instance->timing;
+}
+
+void picopass_poller_set_reference(PicopassPoller* instance, const PicopassDeviceData* reference) {
+    furi_assert(instance);
+    furi_assert(reference);
+    furi_assert(instance->session_state == PicopassPollerSessionStateIdle);
+
+    if(!instance->reference) instance->reference = malloc(sizeof(PicopassDeviceData));
+    memcpy(instance->reference, reference, sizeof(PicopassDeviceData));
+}
+
 void picopass_poller_start(
     PicopassPoller* instance,
     PicopassPollerCallback callback,
@@ -671,6 +1497,8 @@ void picopass_poller_stop(PicopassPoller* instance) {
     instance->session_state = PicopassPollerSessionStateStopRequest;
     nfc_stop(instance->nfc);
     instance->session_state = PicopassPollerSessionStateIdle;
+    // Whatever the card never checked goes back, the scene may save it for next time
+    picopass_poller_return_keys(instance);
 }
 
 PicopassPoller* picopass_poller_alloc(Nfc* nfc) {
@@ -679,12 +1507,18 @@ PicopassPoller* picopass_poller_alloc(Nfc* nfc) {
     PicopassPoller* instance = malloc(sizeof(PicopassPoller));
     instance->nfc = nfc;
     nfc_config(instance->nfc, NfcModePoller, NfcTechIso15693);
-    nfc_set_guard_time_us(instance->nfc, 10000);
-    nfc_set_fdt_poll_fc(instance->nfc, 5000);
-    nfc_set_fdt_poll_poll_us(instance->nfc, 1000);
+    instance->timing = picopass_poller_timing_profiles[PicopassPollerTimingProfileDefault];
+    picopass_poller_apply_timing(instance, &instance->timing);
+
+    instance->detect_config = (PicopassPollerDetectConfig){
+        .fast_delay_ms = PICOPASS_POLLER_DETECT_FAST_DELAY_MS,
+        .fast_attempts = PICOPASS_POLLER_DETECT_FAST_ATTEMPTS,
+        .idle_delay_ms = PICOPASS_POLLER_DETECT_IDLE_DELAY_MS,
+    };
 
     instance->event.data = &instance->event_data;
     instance->data = malloc(sizeof(PicopassDeviceData));
+    loclass_elite_keytable_cache_init(&instance->keytable_cache);
 
     instance->tx_buffer = bit_buffer_alloc(PICOPASS_POLLER_BUFFER_SIZE);
     instance->rx_buffer = bit_buffer_alloc(PICOPASS_POLLER_BUFFER_SIZE);
@@ -696,6 +1530,23 @@ PicopassPoller* picopass_poller_alloc(Nfc* nfc) {
 void picopass_poller_free(PicopassPoller* instance) {
     furi_assert(instance);
 
+    if(instance->prefetch_thread) {
+        furi_thread_flags_set(
+            furi_thread_get_id(instance->prefetch_thread), PICOPASS_POLLER_PREFETCH_FLAG_STOP);
+        furi_thread_join(instance->prefetch_thread);
+        furi_thread_free(instance->prefetch_thread);
+        furi_semaphore_free(instance->prefetch_done);
+    }
+    if(instance->div_table) {
+        iclass_div_table_free(instance->div_table);
+    }
+    if(instance->calibrated) {
+        iclass_timing_free(instance->calibrated);
+    }
+    if(instance->reference) {
+        free(instance->reference);
+    }
+
     free(instance->data);
     bit_buffer_free(instance->tx_buffer);
     bit_buffer_free(instance->rx_buffer);
@@ -708,3 +1559,37 @@ const PicopassDeviceData* picopass_poller_get_data(PicopassPoller* instance) {
 
     return instance->data;
 }
+
+void picopass_poller_get_stats(PicopassPoller* instance, PicopassPollerStats* stats) {
+    furi_assert(instance);
+    furi_assert(stats);
+
+    *stats = instance->stats;
+}
+
+void picopass_poller_get_delta(PicopassPoller* instance, PicopassPollerDelta* delta) {
+    furi_assert(instance);
+    furi_assert(delta);
+
+    *delta = instance->delta;
+}
+
+uint32_t
+    picopass_poller_stats_get_detect_latency(const PicopassPollerStats* stats, uint8_t percent) {
+    furi_assert(stats);
+
+    uint32_t total = 0;
+    for(size_t i = 0; i < PICOPASS_POLLER_DETECT_LATENCY_BUCKETS; i++) {
+        total += stats->detect_latency[i];
+    }
+    if(total == 0) return 0;
+
+    uint32_t wanted = ((uint64_t)total * percent + 99) / 100;
+    uint32_t seen = 0;
+    size_t bucket = 0;
+    for(; bucket < PICOPASS_POLLER_DETECT_LATENCY_BUCKETS - 1; bucket++) {
+        seen += stats->detect_latency[bucket];
+        if(seen >= wanted) break;
+    }
+    return (1UL << bucket) - 1;
+}
@@ -7,26 +7,57 @@
 extern "C" {
 #endif
 
+#define PICOPASS_POLLER_DETECT_LATENCY_BUCKETS (16)
+
 typedef enum {
     PicopassPollerEventTypeRequestMode,
     PicopassPollerEventTypeCardDetected,
     PicopassPollerEventTypeCardLost,
     PicopassPollerEventTypeRequestKey,
+    // A key given with RequestKey that no card checked, in req_key
+    PicopassPollerEventTypeReturnKey,
     PicopassPollerEventTypeRequestWriteBlock,
     PicopassPollerEventTypeRequestWriteKey,
     PicopassPollerEventTypeSuccess,
     PicopassPollerEventTypeFail,
     PicopassPollerEventTypeAuthFail,
+    PicopassPollerEventTypeBatchDetected,
+    PicopassPollerEventTypeCardRead,
+    PicopassPollerEventTypeBatchDone,
+    PicopassPollerEventTypeCalibrated,
 } PicopassPollerEventType;
 
 typedef enum {
     PicopassPollerModeRead,
     PicopassPollerModeWrite,
     PicopassPollerModeWriteKey,
+    // Search the shortest timing the card in the field keeps answering to
+    PicopassPollerModeCalibrate,
 } PicopassPollerMode;
 
+typedef struct {
+    // Field on to the first frame, while the card powers up
+    uint32_t guard_time_us;
+    // End of the card's answer to the next frame
+    uint32_t fdt_poll_fc;
+    // Between one exchange and the next
+    uint32_t fdt_poll_poll_us;
+} PicopassPollerTiming;
+
+typedef enum {
+    // What every card answers to, used unless a card family was calibrated
+    PicopassPollerTimingProfileDefault,
+    // The ISO 15693 minimums, where calibration starts searching from
+    PicopassPollerTimingProfileFast,
+
+    PicopassPollerTimingProfileNum,
+} PicopassPollerTimingProfile;
+
 typedef struct {
     PicopassPollerMode mode;
+    // Read mode only: queue every card in the field and read them in turn, each one is handed
+    // over with PicopassPollerEventTypeCardRead instead of Success/Fail/AuthFail
+    bool batch;
 } PicopassPollerEventDataRequestMode;
 
 typedef struct {
@@ -47,11 +78,24 @@ typedef struct {
     bool is_elite_key;
 } PicopassPollerEventDataRequestWriteKey;
 
+typedef struct {
+    size_t index;
+    size_t count;
+    // CardRead only: every block was read, otherwise the data is what was read before failing
+    bool complete;
+} PicopassPollerEventDataBatch;
+
+typedef struct {
+    PicopassPollerTiming timing;
+} PicopassPollerEventDataCalibrated;
+
 typedef union {
     PicopassPollerEventDataRequestMode req_mode;
     PicopassPollerEventDataRequestKey req_key;
     PicopassPollerEventDataRequestWriteBlock req_write;
     PicopassPollerEventDataRequestWriteKey req_write_key;
+    PicopassPollerEventDataBatch batch;
+    PicopassPollerEventDataCalibrated calibrated;
 } PicopassPollerEventData;
 
 typedef struct {
@@ -59,6 +103,43 @@ typedef struct {
     PicopassPollerEventData* data;
 } PicopassPollerEvent;
 
+typedef struct {
+    // READCHECK returned the epurse the MAC was precomputed over, CHECK went out right away
+    uint32_t mac_precomputed;
+    // No precomputed MAC or the epurse changed, the MAC was computed after READCHECK
+    uint32_t mac_computed;
+    // Keys sent to the card, whether or not the card was still there to answer
+    uint32_t keys_tried;
+    // Time spent by the poller thread while authenticating, in CPU cycles
+    uint64_t rf_cycles;
+    uint64_t div_key_cycles;
+    uint64_t mac_cycles;
+    // Waiting for the prefetch thread, anything above zero means diversifying is the bottleneck
+    uint64_t prefetch_wait_cycles;
+    // Time from entering detect to a card answering ACTALL, bucket i counts up to 2^i - 1 ms
+    uint32_t detect_latency[PICOPASS_POLLER_DETECT_LATENCY_BUCKETS];
+} PicopassPollerStats;
+
+typedef struct {
+    // Delay between ACTALLs right after a card went away or was done with
+    uint32_t fast_delay_ms;
+    // ACTALLs at fast_delay_ms before backing off
+    uint32_t fast_attempts;
+    // Backing off doubles the delay up to this while nothing answers
+    uint32_t idle_delay_ms;
+} PicopassPollerDetectConfig;
+
+typedef struct {
+    // CSN and config match the reference, otherwise the card was read in full
+    bool same_card;
+    // Everything was read, the card was another one or had been written to
+    bool full;
+    // Bit n for block n read from the card, the others were taken from the reference
+    uint32_t read;
+    // Read blocks that differ from the reference or that it did not have
+    uint32_t changed;
+} PicopassPollerDelta;
+
 typedef NfcCommand (*PicopassPollerCallback)(PicopassPollerEvent event, void* context);
 
 typedef struct PicopassPoller PicopassPoller;
@@ -67,6 +148,23 @@ PicopassPoller* picopass_poller_alloc(Nfc* nfc);
 
 void picopass_poller_free(PicopassPoller* instance);
 
+// Detect timing for the next start, by default polls quickly for a moment then backs off to 100 ms
+void picopass_poller_set_detect_config(
+    PicopassPoller* instance,
+    const PicopassPollerDetectConfig* config);
+
+const PicopassPollerTiming*
+    picopass_poller_get_timing_profile(PicopassPollerTimingProfile profile);
+
+// Timing for the next start, Read mode still switches to a card's calibrated timing if it has one
+void picopass_poller_set_timing(PicopassPoller* instance, const PicopassPollerTiming* timing);
+
+void picopass_poller_get_timing(PicopassPoller* instance, PicopassPollerTiming* timing);
+
+// Read mode only, the card is checked against a copy of reference instead of read in full. The
+// header is always read, past that only the credential blocks and what reference lacks.
+void picopass_poller_set_reference(PicopassPoller* instance, const PicopassDeviceData* reference);
+
 void picopass_poller_start(
     PicopassPoller* instance,
     PicopassPollerCallback callback,
@@ -76,6 +174,14 @@ void picopass_poller_stop(PicopassPoller* instance);
 
 const PicopassDeviceData* picopass_poller_get_data(PicopassPoller* instance);
 
+void picopass_poller_get_stats(PicopassPoller* instance, PicopassPollerStats* stats);
+
+void picopass_poller_get_delta(PicopassPoller* instance, PicopassPollerDelta* delta);
+
+// Detect latency in ms that percent of the detections stayed under, rounded up to its bucket
+uint32_t
+    picopass_poller_stats_get_detect_latency(const PicopassPollerStats* stats, uint8_t percent);
+
 #ifdef __cplusplus
 }
 #endif
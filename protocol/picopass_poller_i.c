@@ -22,6 +22,21 @@ static PicopassError picopass_poller_process_error(NfcError error) {
     return ret;
 }
 
+static NfcError picopass_poller_trx(
+    PicopassPoller* instance,
+    BitBuffer* tx_buffer,
+    BitBuffer* rx_buffer,
+    uint32_t fwt_fc) {
+    uint32_t start = picopass_poller_cycles();
+    NfcError error = nfc_poller_trx(instance->nfc, tx_buffer, rx_buffer, fwt_fc);
+    // Only the attack is timed, detecting a card that is not there yet would swamp it
+    if(instance->state == PicopassPollerStateAuth) {
+        instance->stats.rf_cycles += picopass_poller_cycles() - start;
+    }
+
+    return error;
+}
+
 static PicopassError picopass_poller_send_frame(
     PicopassPoller* instance,
     BitBuffer* tx_buffer,
@@ -30,7 +45,7 @@ static PicopassError picopass_poller_send_frame(
     PicopassError ret = PicopassErrorNone;
 
     do {
-        NfcError error = nfc_poller_trx(instance->nfc, tx_buffer, rx_buffer, fwt_fc);
+        NfcError error = picopass_poller_trx(instance, tx_buffer, rx_buffer, fwt_fc);
         if(error != NfcErrorNone) {
             ret = picopass_poller_process_error(error);
             break;
@@ -51,8 +66,24 @@ PicopassError picopass_poller_actall(PicopassPoller* instance) {
     bit_buffer_reset(instance->tx_buffer);
     bit_buffer_append_byte(instance->tx_buffer, RFAL_PICOPASS_CMD_ACTALL);
 
-    NfcError error = nfc_poller_trx(
-        instance->nfc, instance->tx_buffer, instance->rx_buffer, PICOPASS_POLLER_FWT_FC);
+    NfcError error = picopass_poller_trx(
+        instance, instance->tx_buffer, instance->rx_buffer, PICOPASS_POLLER_FWT_FC);
+    if(error != NfcErrorIncompleteFrame) {
+        ret = picopass_poller_process_error(error);
+    }
+
+    return ret;
+}
+
+// Wakes the cards put to sleep with HALT, ACTALL only reaches the ones that are not
+PicopassError picopass_poller_act(PicopassPoller* instance) {
+    PicopassError ret = PicopassErrorNone;
+
+    bit_buffer_reset(instance->tx_buffer);
+    bit_buffer_append_byte(instance->tx_buffer, RFAL_PICOPASS_CMD_ACT);
+
+    NfcError error = picopass_poller_trx(
+        instance, instance->tx_buffer, instance->rx_buffer, PICOPASS_POLLER_FWT_FC);
     if(error != NfcErrorIncompleteFrame) {
         ret = picopass_poller_process_error(error);
     }
@@ -60,6 +91,22 @@ PicopassError picopass_poller_actall(PicopassPoller* instance) {
     return ret;
 }
 
+PicopassError picopass_poller_halt(PicopassPoller* instance) {
+    PicopassError ret = PicopassErrorNone;
+
+    bit_buffer_reset(instance->tx_buffer);
+    bit_buffer_append_byte(instance->tx_buffer, RFAL_PICOPASS_CMD_HALT);
+
+    // A halted card does not answer
+    NfcError error = picopass_poller_trx(
+        instance, instance->tx_buffer, instance->rx_buffer, PICOPASS_POLLER_FWT_FC);
+    if(error != NfcErrorTimeout) {
+        ret = PicopassErrorProtocol;
+    }
+
+    return ret;
+}
+
 PicopassError picopass_poller_identify(
     PicopassPoller* instance,
     PicopassColResSerialNum* col_res_serial_num) {
@@ -132,6 +179,38 @@ PicopassError
     return ret;
 }
 
+PicopassError picopass_poller_read4(
+    PicopassPoller* instance,
+    uint8_t block_num,
+    PicopassBlock blocks[PICOPASS_POLLER_READ4_BLOCKS]) {
+    PicopassError ret = PicopassErrorNone;
+
+    do {
+        bit_buffer_reset(instance->tmp_buffer);
+        bit_buffer_append_byte(instance->tmp_buffer, block_num);
+        iso13239_crc_append(Iso13239CrcTypePicopass, instance->tmp_buffer);
+        bit_buffer_reset(instance->tx_buffer);
+        bit_buffer_append_byte(instance->tx_buffer, RFAL_PICOPASS_CMD_READ4);
+        bit_buffer_append(instance->tx_buffer, instance->tmp_buffer);
+
+        ret = picopass_poller_send_frame(
+            instance, instance->tx_buffer, instance->rx_buffer, PICOPASS_POLLER_FWT_FC);
+        if(ret != PicopassErrorNone) break;
+
+        if(bit_buffer_get_size_bytes(instance->rx_buffer) !=
+           PICOPASS_BLOCK_LEN * PICOPASS_POLLER_READ4_BLOCKS) {
+            ret = PicopassErrorProtocol;
+            break;
+        }
+        const uint8_t* rx_data = bit_buffer_get_data(instance->rx_buffer);
+        for(size_t i = 0; i < PICOPASS_POLLER_READ4_BLOCKS; i++) {
+            memcpy(blocks[i].data, rx_data + i * PICOPASS_BLOCK_LEN, PICOPASS_BLOCK_LEN);
+        }
+    } while(false);
+
+    return ret;
+}
+
 PicopassError
     picopass_poller_read_check(PicopassPoller* instance, PicopassReadCheckResp* read_check_resp) {
     PicopassError ret = PicopassErrorNone;
@@ -141,8 +220,8 @@ PicopassError
         bit_buffer_append_byte(instance->tx_buffer, RFAL_PICOPASS_CMD_READCHECK_KD);
         bit_buffer_append_byte(instance->tx_buffer, 0x02);
 
-        NfcError error = nfc_poller_trx(
-            instance->nfc, instance->tx_buffer, instance->rx_buffer, PICOPASS_POLLER_FWT_FC);
+        NfcError error = picopass_poller_trx(
+            instance, instance->tx_buffer, instance->rx_buffer, PICOPASS_POLLER_FWT_FC);
         if(error != NfcErrorNone) {
             ret = picopass_poller_process_error(error);
             break;
@@ -177,8 +256,8 @@ PicopassError picopass_poller_check(
         }
         bit_buffer_append_bytes(instance->tx_buffer, mac->data, sizeof(PicopassMac));
 
-        NfcError error = nfc_poller_trx(
-            instance->nfc, instance->tx_buffer, instance->rx_buffer, PICOPASS_POLLER_FWT_FC);
+        NfcError error = picopass_poller_trx(
+            instance, instance->tx_buffer, instance->rx_buffer, PICOPASS_POLLER_FWT_FC);
         if(error != NfcErrorNone) {
             ret = picopass_poller_process_error(error);
             break;
@@ -209,8 +288,8 @@ PicopassError picopass_poller_write_block(
         bit_buffer_append_bytes(instance->tx_buffer, block->data, PICOPASS_BLOCK_LEN);
         bit_buffer_append_bytes(instance->tx_buffer, mac->data, sizeof(PicopassMac));
 
-        NfcError error = nfc_poller_trx(
-            instance->nfc, instance->tx_buffer, instance->rx_buffer, PICOPASS_POLLER_FWT_FC);
+        NfcError error = picopass_poller_trx(
+            instance, instance->tx_buffer, instance->rx_buffer, PICOPASS_POLLER_FWT_FC);
         if(error != NfcErrorNone) {
             ret = picopass_poller_process_error(error);
             break;
@@ -4,9 +4,28 @@
 #include "picopass_protocol.h"
 
 #include <nfc/helpers/iso13239_crc.h>
+#include <optimized_elite.h>
+#include <furi/furi.h>
+#include <furi_hal.h>
+
+#include "../helpers/iclass_div_table.h"
+#include "../helpers/iclass_timing.h"
 
 #define PICOPASS_POLLER_BUFFER_SIZE (255)
 #define PICOPASS_CRC_SIZE           (2)
+// Dictionary keys checked against a captured NR-MAC per poller tick, one bitsliced MAC pass
+#define PICOPASS_POLLER_OFFLINE_KEY_BATCH   (LOCLASS_OPT_MULTI_KEYS)
+#define PICOPASS_POLLER_PENDING_KEYS        (PICOPASS_POLLER_OFFLINE_KEY_BATCH)
+#define PICOPASS_POLLER_PREFETCH_STACK_SIZE (2048)
+#define PICOPASS_POLLER_BATCH_MAX_CARDS     (16)
+#define PICOPASS_POLLER_READ4_BLOCKS        (4)
+// Probes in a row a timing value has to pass during calibration
+#define PICOPASS_POLLER_CALIBRATE_PROBES (8)
+// Read again by every delta read: CSN, config, epurse and AIA before auth, the credential after
+#define PICOPASS_POLLER_DELTA_HEADER_BLOCKS   (0x27UL)
+#define PICOPASS_POLLER_DELTA_VOLATILE_BLOCKS (0x3C0UL)
+// IDENTIFY answers from several cards at once come back as CRC errors
+#define PICOPASS_POLLER_BATCH_MAX_COLLISIONS (8)
 
 typedef enum {
     PicopassPollerSessionStateIdle,
@@ -18,9 +37,12 @@ typedef enum {
     PicopassPollerStateRequestMode,
     PicopassPollerStateDetect,
     PicopassPollerStateSelect,
+    PicopassPollerStateEnumerate,
     PicopassPollerStatePreAuth,
     PicopassPollerStateCheckSecurity,
     PicopassPollerStateNrMacAuth,
+    PicopassPollerStateNrMacOfflineAuth,
+    PicopassPollerStateNrMacReplay,
     PicopassPollerStateAuth,
     PicopassPollerStateReadBlock,
     PicopassPollerStateWriteBlock,
@@ -30,23 +52,111 @@ typedef enum {
     PicopassPollerStateSuccess,
     PicopassPollerStateFail,
     PicopassPollerStateAuthFail,
+    PicopassPollerStateCalibrate,
 
     PicopassPollerStateNum,
 } PicopassPollerState;
 
+// Dictionary key diversified on the prefetch thread while the previous key is on air, with its
+// reader MAC over the CC the card is expected to answer READCHECK with
+typedef struct {
+    uint8_t key[PICOPASS_KEY_LEN];
+    bool is_elite_key;
+    uint8_t csn[PICOPASS_BLOCK_LEN];
+    uint8_t cc[PICOPASS_BLOCK_LEN];
+    uint8_t div_key[PICOPASS_KEY_LEN];
+    PicopassMac mac;
+} PicopassPollerPrefetch;
+
+typedef struct {
+    uint8_t key[PICOPASS_KEY_LEN];
+    bool is_elite_key;
+} PicopassPollerKey;
+
+// Card found by anticollision, selected again by its anticollision CSN when its turn comes
+typedef struct {
+    PicopassColResSerialNum col_res_serial_num;
+    PicopassSerialNum serial_num;
+} PicopassPollerBatchCard;
+
+typedef enum {
+    PicopassPollerTimingParamGuardTime,
+    PicopassPollerTimingParamFdtPoll,
+    PicopassPollerTimingParamFdtPollPoll,
+
+    PicopassPollerTimingParamNum,
+} PicopassPollerTimingParam;
+
+// Binary search of one timing value after the other, low is known not to work yet and high to work
+typedef struct {
+    bool started;
+    PicopassPollerTimingParam param;
+    PicopassPollerTiming timing;
+    uint32_t low;
+    uint32_t high;
+    // Probes answered in a row at the value under test
+    uint8_t probes;
+    // The value under test is applied, the next tick probes the card with it
+    bool armed;
+} PicopassPollerCalibration;
+
 struct PicopassPoller {
     Nfc* nfc;
     PicopassPollerSessionState session_state;
     PicopassPollerState state;
     PicopassPollerMode mode;
+    bool batch;
+    PicopassPollerBatchCard batch_cards[PICOPASS_POLLER_BATCH_MAX_CARDS];
+    size_t batch_count;
+    size_t batch_index;
 
     PicopassColResSerialNum col_res_serial_num;
     PicopassSerialNum serial_num;
     PicopassMac mac;
     uint8_t div_key[8];
+    uint8_t nr_mac[PICOPASS_BLOCK_LEN];
+    bool offline_key_found;
+    LoclassEliteKeytableCache_t keytable_cache;
+    FuriThread* prefetch_thread;
+    FuriSemaphore* prefetch_done;
+    PicopassPollerPrefetch prefetch;
+    // Only touched by the prefetch thread
+    LoclassEliteKeytableCache_t prefetch_keytable_cache;
+    bool prefetch_pending;
+    // Keys the scene gave for pending_csn that the card never checked, oldest first. They go
+    // before the prefetched key and back to the scene when another card is selected.
+    PicopassPollerKey pending_keys[PICOPASS_POLLER_PENDING_KEYS];
+    size_t num_pending_keys;
+    uint8_t pending_csn[PICOPASS_BLOCK_LEN];
+    // Standard KDF div keys precomputed for div_table_csn, NULL when it has no table
+    IclassDivTable* div_table;
+    uint8_t div_table_csn[PICOPASS_BLOCK_LEN];
+    bool div_table_checked;
+    // CC from the last READCHECK, or the epurse read before auth
+    uint8_t expected_cc[PICOPASS_BLOCK_LEN];
+    PicopassPollerStats stats;
     uint8_t current_block;
     uint8_t app_limit;
     bool secured;
+    // The card answered READ4 with an error once, the rest of it is read a block at a time
+    bool read4_failed;
+    PicopassPollerDetectConfig detect_config;
+    // ACTALLs nobody answered since entering detect, and when that was
+    uint32_t detect_misses;
+    uint32_t detect_start_tick;
+    bool success_reported;
+    // Set by the scene, calibrated is what a card family was calibrated to
+    PicopassPollerTiming timing;
+    IclassTiming* calibrated;
+    bool calibrated_active;
+    // The last card failed on its calibrated timing, the next attempt uses timing
+    bool calibrated_skip;
+    PicopassPollerCalibration calibration;
+    // Saved card a delta read compares against, NULL for a normal read
+    PicopassDeviceData* reference;
+    PicopassPollerDelta delta;
+    // Blocks past the header the read handler fetches
+    uint32_t delta_blocks;
 
     PicopassDeviceData* data;
 
@@ -60,8 +170,17 @@ struct PicopassPoller {
     void* context;
 };
 
+// DWT cycle counter, wraps about once a minute so it only times spans shorter than that
+static inline uint32_t picopass_poller_cycles(void) {
+    return furi_hal_cortex_timer_get(0).start;
+}
+
 PicopassError picopass_poller_actall(PicopassPoller* instance);
 
+PicopassError picopass_poller_act(PicopassPoller* instance);
+
+PicopassError picopass_poller_halt(PicopassPoller* instance);
+
 PicopassError
     picopass_poller_identify(PicopassPoller* instance, PicopassColResSerialNum* col_res_serial_num);
 
@@ -73,6 +192,11 @@ PicopassError picopass_poller_select(
 PicopassError
     picopass_poller_read_block(PicopassPoller* instance, uint8_t block_num, PicopassBlock* block);
 
+PicopassError picopass_poller_read4(
+    PicopassPoller* instance,
+    uint8_t block_num,
+    PicopassBlock blocks[PICOPASS_POLLER_READ4_BLOCKS]);
+
 PicopassError
     picopass_poller_read_check(PicopassPoller* instance, PicopassReadCheckResp* read_check_resp);
 
@@ -0,0 +1,171 @@
+#include "../picopass_i.h"
+#include <dolphin/dolphin.h>
+
+#define TAG "PicopassSceneBatchRead"
+
+// A whole stack, the poller hands over at most 16 cards per anticollision round
+#define PICOPASS_BATCH_READ_QUEUE_SIZE (16)
+
+typedef struct {
+    PicopassDeviceData data;
+    // Every block was read
+    bool complete;
+} PicopassBatchReadCard;
+
+// Cards in a stack usually share a key, the one that opened the first card is tried first
+static const IclassKeySource picopass_batch_read_sources[] = {
+    IclassKeySourceHits,
+    IclassKeySourceStandardDict,
+    IclassKeySourceEliteDict,
+};
+
+// Every card is saved as its CSN, with -partial when it could not be read in full
+static bool picopass_batch_read_save(Picopass* picopass, bool complete) {
+    PicopassDevice* dev = picopass->dev;
+    const uint8_t* csn = dev->dev_data.card_data[PICOPASS_CSN_BLOCK_INDEX].data;
+    if(!dev->dev_data.card_data[PICOPASS_CSN_BLOCK_INDEX].valid) return false;
+
+    char name[PICOPASS_BLOCK_LEN * 2 + sizeof("-partial")] = {};
+    for(size_t i = 0; i < PICOPASS_BLOCK_LEN; i++) {
+        snprintf(name + 2 * i, sizeof(name) - 2 * i, "%02X", csn[i]);
+    }
+    if(!complete) strlcat(name, "-partial", sizeof(name));
+
+    dev->format = complete ? PicopassDeviceSaveFormatOriginal : PicopassDeviceSaveFormatPartial;
+    FURI_LOG_D(TAG, "Saving %s", name);
+    return picopass_device_save(dev, name);
+}
+
+NfcCommand picopass_batch_read_worker_callback(PicopassPollerEvent event, void* context) {
+    furi_assert(context);
+    NfcCommand command = NfcCommandContinue;
+
+    Picopass* picopass = context;
+    PicopassBatchReadContext* ctx = &picopass->batch_read_ctx;
+
+    if(event.type == PicopassPollerEventTypeRequestMode) {
+        event.data->req_mode.mode = PicopassPollerModeRead;
+        event.data->req_mode.batch = true;
+    } else if(event.type == PicopassPollerEventTypeRequestKey) {
+        uint8_t key[PICOPASS_KEY_LEN] = {};
+        bool is_elite_key = false;
+        bool is_key_provided = iclass_key_iter_next(picopass->key_iter, key, &is_elite_key);
+        memcpy(event.data->req_key.key, key, PICOPASS_KEY_LEN);
+        event.data->req_key.is_elite_key = is_elite_key;
+        event.data->req_key.is_key_provided = is_key_provided;
+    } else if(event.type == PicopassPollerEventTypeReturnKey) {
+        iclass_key_iter_put_back(
+            picopass->key_iter, event.data->req_key.key, event.data->req_key.is_elite_key);
+    } else if(event.type == PicopassPollerEventTypeBatchDetected) {
+        // Counts add up over every stack presented while the scene is open
+        ctx->cards += event.data->batch.count;
+        view_dispatcher_send_custom_event(
+            picopass->view_dispatcher, PicopassCustomEventBatchReadUpdate);
+    } else if(event.type == PicopassPollerEventTypeCardRead) {
+        // Copied out since the poller overwrites its data with the next card, the remaining
+        // cards wait in HALT so storage is left to the scene thread
+        PicopassBatchReadCard card = {.complete = event.data->batch.complete};
+        memcpy(
+            &card.data, picopass_poller_get_data(picopass->poller), sizeof(PicopassDeviceData));
+        if(furi_message_queue_put(ctx->cards_read, &card, 0) != FuriStatusOk) {
+            FURI_LOG_W(TAG, "Card queue full, card not saved");
+        }
+        iclass_key_iter_reset(picopass->key_iter);
+        view_dispatcher_send_custom_event(
+            picopass->view_dispatcher, PicopassCustomEventBatchReadUpdate);
+    } else if(event.type == PicopassPollerEventTypeBatchDone) {
+        notification_message(picopass->notifications, &sequence_success);
+    }
+
+    return command;
+}
+
+static void picopass_scene_batch_read_save_cards(Picopass* picopass) {
+    PicopassBatchReadContext* ctx = &picopass->batch_read_ctx;
+    PicopassBatchReadCard card;
+
+    while(furi_message_queue_get(ctx->cards_read, &card, 0) == FuriStatusOk) {
+        memcpy(&picopass->dev->dev_data, &card.data, sizeof(PicopassDeviceData));
+        if(card.complete && card.data.auth == PicopassDeviceAuthMethodKey) {
+            iclass_key_hits_record(card.data.pacs.key, card.data.pacs.elite_kdf);
+        }
+        ctx->read++;
+        if(picopass_batch_read_save(picopass, card.complete)) ctx->saved++;
+        if(!card.complete) ctx->failed++;
+    }
+}
+
+static void picopass_scene_batch_read_update_view(Picopass* picopass) {
+    PicopassBatchReadContext* ctx = &picopass->batch_read_ctx;
+    Popup* popup = picopass->popup;
+
+    if(ctx->cards == 0) {
+        popup_set_header(popup, "Present\npicopass\ncards", 68, 30, AlignLeft, AlignTop);
+        popup_set_text(popup, NULL, 0, 0, AlignLeft, AlignTop);
+    } else {
+        popup_set_header(popup, "Batch Read", 68, 4, AlignLeft, AlignTop);
+        snprintf(
+            picopass->text_store,
+            sizeof(picopass->text_store),
+            "Read %zu/%zu\nSaved %zu\nFailed %zu",
+            ctx->read,
+            ctx->cards,
+            ctx->saved,
+            ctx->failed);
+        popup_set_text(popup, picopass->text_store, 68, 20, AlignLeft, AlignTop);
+    }
+}
+
+void picopass_scene_batch_read_on_enter(void* context) {
+    Picopass* picopass = context;
+    dolphin_deed(DolphinDeedNfcRead);
+
+    memset(&picopass->batch_read_ctx, 0, sizeof(PicopassBatchReadContext));
+    picopass->batch_read_ctx.cards_read =
+        furi_message_queue_alloc(PICOPASS_BATCH_READ_QUEUE_SIZE, sizeof(PicopassBatchReadCard));
+
+    // Setup view
+    Popup* popup = picopass->popup;
+    popup_set_icon(popup, 0, 3, &I_RFIDDolphinReceive_97x61);
+    picopass_scene_batch_read_update_view(picopass);
+
+    picopass->key_iter = iclass_key_iter_alloc(
+        picopass_batch_read_sources, COUNT_OF(picopass_batch_read_sources));
+    // Start worker
+    picopass->poller = picopass_poller_alloc(picopass->nfc);
+    picopass_poller_start(picopass->poller, picopass_batch_read_worker_callback, picopass);
+
+    view_dispatcher_switch_to_view(picopass->view_dispatcher, PicopassViewPopup);
+    picopass_blink_start(picopass);
+}
+
+bool picopass_scene_batch_read_on_event(void* context, SceneManagerEvent event) {
+    Picopass* picopass = context;
+    bool consumed = false;
+
+    if(event.type == SceneManagerEventTypeCustom) {
+        if(event.event == PicopassCustomEventBatchReadUpdate) {
+            picopass_scene_batch_read_save_cards(picopass);
+            picopass_scene_batch_read_update_view(picopass);
+            consumed = true;
+        }
+    }
+    return consumed;
+}
+
+void picopass_scene_batch_read_on_exit(void* context) {
+    Picopass* picopass = context;
+
+    picopass_poller_stop(picopass->poller);
+    picopass_poller_free(picopass->poller);
+    iclass_key_iter_free(picopass->key_iter);
+    picopass->key_iter = NULL;
+    // Cards read just before leaving
+    picopass_scene_batch_read_save_cards(picopass);
+    furi_message_queue_free(picopass->batch_read_ctx.cards_read);
+
+    // Clear view
+    popup_reset(picopass->popup);
+
+    picopass_blink_stop(picopass);
+}
@@ -0,0 +1,88 @@
+#include "../picopass_i.h"
+#include <dolphin/dolphin.h>
+
+#define TAG "PicopassSceneCalibrateTiming"
+
+NfcCommand picopass_calibrate_timing_worker_callback(PicopassPollerEvent event, void* context) {
+    furi_assert(context);
+    NfcCommand command = NfcCommandContinue;
+
+    Picopass* picopass = context;
+
+    if(event.type == PicopassPollerEventTypeRequestMode) {
+        event.data->req_mode.mode = PicopassPollerModeCalibrate;
+    } else if(event.type == PicopassPollerEventTypeCalibrated) {
+        // Stored for the card's family, later reads of any card in it use the result
+        const PicopassDeviceData* data = picopass_poller_get_data(picopass->poller);
+        picopass->calibrated_timing = event.data->calibrated.timing;
+        iclass_timing_record(
+            data->card_data[PICOPASS_CSN_BLOCK_INDEX].data, &picopass->calibrated_timing);
+        view_dispatcher_send_custom_event(
+            picopass->view_dispatcher, PicopassCustomEventPollerSuccess);
+    } else if(event.type == PicopassPollerEventTypeFail) {
+        // The card moved or went away, calibration starts over when it is back
+        uint32_t ticks = furi_get_tick();
+        if(picopass->last_error_notify_ticks + furi_ms_to_ticks(500) < ticks) {
+            picopass->last_error_notify_ticks = ticks;
+            notification_message(picopass->notifications, &sequence_error);
+        }
+    }
+
+    return command;
+}
+
+void picopass_scene_calibrate_timing_on_enter(void* context) {
+    Picopass* picopass = context;
+    dolphin_deed(DolphinDeedNfcRead);
+
+    picopass->last_error_notify_ticks = 0;
+
+    // Setup view
+    Popup* popup = picopass->popup;
+    popup_set_header(popup, "Hold card\nstill to\ncalibrate", 68, 30, AlignLeft, AlignTop);
+    popup_set_icon(popup, 0, 3, &I_RFIDDolphinReceive_97x61);
+
+    // Start worker
+    picopass->poller = picopass_poller_alloc(picopass->nfc);
+    picopass_poller_start(picopass->poller, picopass_calibrate_timing_worker_callback, picopass);
+
+    view_dispatcher_switch_to_view(picopass->view_dispatcher, PicopassViewPopup);
+    picopass_blink_start(picopass);
+}
+
+bool picopass_scene_calibrate_timing_on_event(void* context, SceneManagerEvent event) {
+    Picopass* picopass = context;
+    bool consumed = false;
+
+    if(event.type == SceneManagerEventTypeCustom) {
+        if(event.event == PicopassCustomEventPollerSuccess) {
+            const PicopassPollerTiming* timing = &picopass->calibrated_timing;
+            Popup* popup = picopass->popup;
+            popup_set_header(popup, "Calibrated", 68, 4, AlignLeft, AlignTop);
+            snprintf(
+                picopass->text_store,
+                sizeof(picopass->text_store),
+                "Guard %lu us\nFDT %lu fc\nPoll %lu us",
+                timing->guard_time_us,
+                timing->fdt_poll_fc,
+                timing->fdt_poll_poll_us);
+            popup_set_text(popup, picopass->text_store, 68, 20, AlignLeft, AlignTop);
+            picopass_blink_stop(picopass);
+            notification_message(picopass->notifications, &sequence_success);
+            consumed = true;
+        }
+    }
+    return consumed;
+}
+
+void picopass_scene_calibrate_timing_on_exit(void* context) {
+    Picopass* picopass = context;
+
+    picopass_poller_stop(picopass->poller);
+    picopass_poller_free(picopass->poller);
+
+    // Clear view
+    popup_reset(picopass->popup);
+
+    picopass_blink_stop(picopass);
+}
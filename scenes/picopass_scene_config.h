@@ -26,3 +26,6 @@ ADD_SCENE(picopass, formats, Formats)
 ADD_SCENE(picopass, acknowledgements, Acknowledgements)
 ADD_SCENE(picopass, elite_keygen_attack, EliteKeygenAttack)
 ADD_SCENE(picopass, parse_sio, ParseSIO)
+ADD_SCENE(picopass, batch_read, BatchRead)
+ADD_SCENE(picopass, calibrate_timing, CalibrateTiming)
+ADD_SCENE(picopass, delta_read, DeltaRead)
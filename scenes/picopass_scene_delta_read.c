@@ -0,0 +1,202 @@
+#include "../picopass_i.h"
+#include <dolphin/dolphin.h>
+
+#define TAG "PicopassSceneDeltaRead"
+
+static const IclassKeySource picopass_delta_read_sources[] = {
+    IclassKeySourceHits,
+    IclassKeySourceStandardDict,
+    IclassKeySourceEliteDict,
+};
+
+NfcCommand picopass_delta_read_worker_callback(PicopassPollerEvent event, void* context) {
+    furi_assert(context);
+    NfcCommand command = NfcCommandContinue;
+
+    Picopass* picopass = context;
+
+    if(event.type == PicopassPollerEventTypeRequestMode) {
+        event.data->req_mode.mode = PicopassPollerModeRead;
+    } else if(event.type == PicopassPollerEventTypeRequestKey) {
+        PicopassDeltaReadContext* ctx = &picopass->delta_read_ctx;
+        uint8_t key[PICOPASS_KEY_LEN] = {};
+        bool is_elite_key = false;
+        bool is_key_provided = false;
+        // Only known when the card was read in this session, it isn't saved with the card
+        if(!ctx->reference_key_sent && ctx->reference.auth == PicopassDeviceAuthMethodKey) {
+            ctx->reference_key_sent = true;
+            memcpy(key, ctx->reference.pacs.key, PICOPASS_KEY_LEN);
+            is_elite_key = ctx->reference.pacs.elite_kdf;
+            is_key_provided = true;
+        } else {
+            is_key_provided = iclass_key_iter_next(picopass->key_iter, key, &is_elite_key);
+        }
+        memcpy(event.data->req_key.key, key, PICOPASS_KEY_LEN);
+        event.data->req_key.is_elite_key = is_elite_key;
+        event.data->req_key.is_key_provided = is_key_provided;
+    } else if(event.type == PicopassPollerEventTypeReturnKey) {
+        iclass_key_iter_put_back(
+            picopass->key_iter, event.data->req_key.key, event.data->req_key.is_elite_key);
+    } else if(
+        event.type == PicopassPollerEventTypeSuccess ||
+        event.type == PicopassPollerEventTypeAuthFail) {
+        const PicopassDeviceData* data = picopass_poller_get_data(picopass->poller);
+        memcpy(&picopass->dev->dev_data, data, sizeof(PicopassDeviceData));
+        picopass_poller_get_delta(picopass->poller, &picopass->delta_read_ctx.delta);
+        view_dispatcher_send_custom_event(
+            picopass->view_dispatcher, PicopassCustomEventPollerSuccess);
+    } else if(event.type == PicopassPollerEventTypeFail) {
+        uint32_t ticks = furi_get_tick();
+        if(picopass->last_error_notify_ticks + furi_ms_to_ticks(500) < ticks) {
+            picopass->last_error_notify_ticks = ticks;
+            notification_message(picopass->notifications, &sequence_error);
+        }
+    }
+
+    return command;
+}
+
+void picopass_scene_delta_read_widget_callback(
+    GuiButtonType result,
+    InputType type,
+    void* context) {
+    furi_assert(context);
+    Picopass* picopass = context;
+
+    if(type == InputTypeShort) {
+        view_dispatcher_send_custom_event(picopass->view_dispatcher, result);
+    }
+}
+
+// Every changed block with what was saved and what the card holds now
+static void picopass_scene_delta_read_show_result(Picopass* picopass) {
+    PicopassDeltaReadContext* ctx = &picopass->delta_read_ctx;
+    const PicopassPollerDelta* delta = &ctx->delta;
+    FuriString* str = picopass->text_box_store;
+    furi_string_reset(str);
+    Widget* widget = picopass->widget;
+
+    if(picopass->dev->dev_data.auth == PicopassDeviceAuthMethodFailed) {
+        // Only what needs no key was read, there is nothing to compare
+        furi_string_cat_printf(
+            str, "\e#Auth Failed\n%s\n", delta->same_card ? "No key opened it" : "Different card");
+        widget_add_text_scroll_element(widget, 0, 0, 128, 64, furi_string_get_cstr(str));
+        view_dispatcher_switch_to_view(picopass->view_dispatcher, PicopassViewWidget);
+        return;
+    }
+
+    size_t read = 0;
+    size_t changed = 0;
+    for(size_t i = 0; i < PICOPASS_MAX_APP_LIMIT; i++) {
+        if(delta->read & (1UL << i)) read++;
+        if(delta->changed & (1UL << i)) changed++;
+    }
+
+    if(!delta->same_card) {
+        furi_string_cat_printf(str, "\e#Different card\n");
+    } else if(changed == 0) {
+        furi_string_cat_printf(str, "\e#No changes\n");
+    } else {
+        furi_string_cat_printf(str, "\e#%zu blocks changed\n", changed);
+    }
+    furi_string_cat_printf(str, "%zu blocks read%s\n", read, delta->full ? ", in full" : "");
+
+    for(size_t i = 0; delta->same_card && i < PICOPASS_MAX_APP_LIMIT; i++) {
+        if(!(delta->changed & (1UL << i))) continue;
+        const PicopassBlock* before = &ctx->reference.card_data[i];
+        const PicopassBlock* after = &picopass->dev->dev_data.card_data[i];
+        furi_string_cat_printf(str, "Block %zu\n-", i);
+        for(size_t j = 0; j < PICOPASS_BLOCK_LEN; j++) {
+            if(before->valid) {
+                furi_string_cat_printf(str, "%02X", before->data[j]);
+            } else {
+                furi_string_cat_printf(str, "??");
+            }
+        }
+        furi_string_cat_printf(str, "\n+");
+        for(size_t j = 0; j < PICOPASS_BLOCK_LEN; j++) {
+            furi_string_cat_printf(str, "%02X", after->data[j]);
+        }
+        furi_string_cat_printf(str, "\n");
+    }
+
+    widget_add_text_scroll_element(widget, 0, 0, 128, 52, furi_string_get_cstr(str));
+    if(changed > 0) {
+        widget_add_button_element(
+            widget,
+            GuiButtonTypeRight,
+            "Save",
+            picopass_scene_delta_read_widget_callback,
+            picopass);
+    }
+    view_dispatcher_switch_to_view(picopass->view_dispatcher, PicopassViewWidget);
+}
+
+void picopass_scene_delta_read_on_enter(void* context) {
+    Picopass* picopass = context;
+    dolphin_deed(DolphinDeedNfcRead);
+
+    picopass->last_error_notify_ticks = 0;
+    memcpy(
+        &picopass->delta_read_ctx.reference,
+        &picopass->dev->dev_data,
+        sizeof(PicopassDeviceData));
+    picopass->delta_read_ctx.reference_key_sent = false;
+
+    // Setup view
+    Popup* popup = picopass->popup;
+    popup_set_header(popup, "Present\nsaved\ncard", 68, 30, AlignLeft, AlignTop);
+    popup_set_icon(popup, 0, 3, &I_RFIDDolphinReceive_97x61);
+
+    picopass->key_iter = iclass_key_iter_alloc(
+        picopass_delta_read_sources, COUNT_OF(picopass_delta_read_sources));
+    // Start worker
+    picopass->poller = picopass_poller_alloc(picopass->nfc);
+    picopass_poller_set_reference(picopass->poller, &picopass->delta_read_ctx.reference);
+    picopass_poller_start(picopass->poller, picopass_delta_read_worker_callback, picopass);
+
+    view_dispatcher_switch_to_view(picopass->view_dispatcher, PicopassViewPopup);
+    picopass_blink_start(picopass);
+}
+
+bool picopass_scene_delta_read_on_event(void* context, SceneManagerEvent event) {
+    Picopass* picopass = context;
+    bool consumed = false;
+
+    if(event.type == SceneManagerEventTypeCustom) {
+        if(event.event == PicopassCustomEventPollerSuccess) {
+            picopass_blink_stop(picopass);
+            bool auth_failed = picopass->dev->dev_data.auth == PicopassDeviceAuthMethodFailed;
+            notification_message(
+                picopass->notifications, auth_failed ? &sequence_error : &sequence_success);
+            picopass_scene_delta_read_show_result(picopass);
+            consumed = true;
+        } else if(event.event == GuiButtonTypeRight) {
+            picopass->dev->format = PicopassDeviceSaveFormatOriginal;
+            scene_manager_next_scene(picopass->scene_manager, PicopassSceneSaveName);
+            consumed = true;
+        }
+    } else if(event.type == SceneManagerEventTypeBack) {
+        // Back to the card as saved, not the one just read
+        memcpy(
+            &picopass->dev->dev_data,
+            &picopass->delta_read_ctx.reference,
+            sizeof(PicopassDeviceData));
+    }
+    return consumed;
+}
+
+void picopass_scene_delta_read_on_exit(void* context) {
+    Picopass* picopass = context;
+
+    picopass_poller_stop(picopass->poller);
+    picopass_poller_free(picopass->poller);
+    iclass_key_iter_free(picopass->key_iter);
+    picopass->key_iter = NULL;
+
+    // Clear view
+    popup_reset(picopass->popup);
+    widget_reset(picopass->widget);
+
+    picopass_blink_stop(picopass);
+}
@@ -4,53 +4,56 @@
 
 #define PICOPASS_SCENE_DICT_ATTACK_KEYS_BATCH_UPDATE (10)
 
+#define PICOPASS_SCENE_DICT_ATTACK_JOURNAL "dict"
+
 #define TAG "PicopassSceneEliteDictAttack"
 
-enum {
-    PicopassSceneEliteDictAttackDictEliteUser,
-    PicopassSceneEliteDictAttackDictStandard,
-    PicopassSceneEliteDictAttackDictElite,
+// The card stays on the reader for the whole attack, when it slips keep looking for it quickly
+static const PicopassPollerDetectConfig picopass_dict_attack_detect_config = {
+    .fast_delay_ms = 5,
+    .fast_attempts = 200,
+    .idle_delay_ms = 100,
+};
+
+static const IclassKeySource picopass_dict_attack_sources[] = {
+    IclassKeySourceHits,
+    IclassKeySourceUserDict,
+    IclassKeySourceStandardDict,
+    IclassKeySourceEliteDict,
 };
 
 const char* picopass_dict_name[] = {
-    [PicopassSceneEliteDictAttackDictEliteUser] = "Elite User Dictionary",
-    [PicopassSceneEliteDictAttackDictStandard] = "Standard System Dictionary",
-    [PicopassSceneEliteDictAttackDictElite] = "Elite System Dictionary",
+    [IclassKeySourceHits] = "Previously Found Keys",
+    [IclassKeySourceUserDict] = "Elite User Dictionary",
+    [IclassKeySourceStandardDict] = "Standard System Dictionary",
+    [IclassKeySourceEliteDict] = "Elite System Dictionary",
+    [IclassKeySourceKeygen] = "Elite Keygen Attack",
 };
 
-static bool picopass_elite_dict_attack_change_dict(Picopass* picopass) {
-    bool success = false;
+static void picopass_elite_dict_attack_update_ctx(Picopass* picopass) {
+    IclassKeySource source;
+    if(!iclass_key_iter_get_source(picopass->key_iter, &source)) return;
 
-    do {
-        uint32_t scene_state =
-            scene_manager_get_scene_state(picopass->scene_manager, PicopassSceneEliteDictAttack);
-        keys_dict_free(picopass->dict);
-        picopass->dict = NULL;
-        if(scene_state == PicopassSceneEliteDictAttackDictElite) break;
-        if(scene_state == PicopassSceneEliteDictAttackDictEliteUser) {
-            if(!keys_dict_check_presence(PICOPASS_ICLASS_STANDARD_DICT_FLIPPER_NAME)) break;
-            picopass->dict = keys_dict_alloc(
-                PICOPASS_ICLASS_STANDARD_DICT_FLIPPER_NAME,
-                KeysDictModeOpenExisting,
-                PICOPASS_KEY_LEN);
-            scene_state = PicopassSceneEliteDictAttackDictStandard;
-        } else if(scene_state == PicopassSceneEliteDictAttackDictStandard) {
-            if(!keys_dict_check_presence(PICOPASS_ICLASS_ELITE_DICT_FLIPPER_NAME)) break;
-            picopass->dict = keys_dict_alloc(
-                PICOPASS_ICLASS_ELITE_DICT_FLIPPER_NAME,
-                KeysDictModeOpenExisting,
-                PICOPASS_KEY_LEN);
-            scene_state = PicopassSceneEliteDictAttackDictElite;
-        }
-        picopass->dict_attack_ctx.total_keys = keys_dict_get_total_keys(picopass->dict);
-        picopass->dict_attack_ctx.current_key = 0;
-        picopass->dict_attack_ctx.name = picopass_dict_name[scene_state];
-        scene_manager_set_scene_state(
-            picopass->scene_manager, PicopassSceneEliteDictAttack, scene_state);
-        success = true;
-    } while(false);
+    picopass->dict_attack_ctx.source = source;
+    picopass->dict_attack_ctx.name = picopass_dict_name[source];
+    picopass->dict_attack_ctx.total_keys = iclass_key_iter_get_source_total(picopass->key_iter);
+    picopass->dict_attack_ctx.current_key =
+        iclass_key_iter_get_source_position(picopass->key_iter);
+}
+
+// Keys already tried belong to one card, so a new CSN saves the old card and picks up its own
+static void picopass_elite_dict_attack_select_card(Picopass* picopass, const uint8_t* csn) {
+    PicopassDictAttackContext* ctx = &picopass->dict_attack_ctx;
+    if(ctx->csn_valid && memcmp(ctx->csn, csn, PICOPASS_BLOCK_LEN) == 0) return;
 
-    return success;
+    if(ctx->csn_valid) {
+        iclass_attack_journal_save(
+            PICOPASS_SCENE_DICT_ATTACK_JOURNAL, ctx->csn, picopass->key_iter);
+        iclass_key_iter_reset(picopass->key_iter);
+    }
+    iclass_attack_journal_load(PICOPASS_SCENE_DICT_ATTACK_JOURNAL, csn, picopass->key_iter);
+    memcpy(ctx->csn, csn, PICOPASS_BLOCK_LEN);
+    ctx->csn_valid = true;
 }
 
 NfcCommand picopass_elite_dict_attack_worker_callback(PicopassPollerEvent event, void* context) {
@@ -63,37 +66,49 @@ NfcCommand picopass_elite_dict_attack_worker_callback(PicopassPollerEvent event,
         event.data->req_mode.mode = PicopassPollerModeRead;
     } else if(event.type == PicopassPollerEventTypeRequestKey) {
         uint8_t key[PICOPASS_KEY_LEN] = {};
+        bool is_elite_key = false;
         bool is_key_provided = true;
-        if(!keys_dict_get_next_key(picopass->dict, key, PICOPASS_KEY_LEN)) {
-            if(picopass_elite_dict_attack_change_dict(picopass)) {
-                is_key_provided = keys_dict_get_next_key(picopass->dict, key, PICOPASS_KEY_LEN);
-                view_dispatcher_send_custom_event(
-                    picopass->view_dispatcher, PicopassCustomEventDictAttackUpdateView);
-            } else {
-                is_key_provided = false;
-            }
+        const PicopassDeviceData* data = picopass_poller_get_data(picopass->poller);
+        picopass_elite_dict_attack_select_card(
+            picopass, data->card_data[PICOPASS_CSN_BLOCK_INDEX].data);
+        // The iterator is only touched from the worker, skips requested from the GUI land here
+        if(picopass->dict_attack_ctx.skip_source) {
+            picopass->dict_attack_ctx.skip_source = false;
+            is_key_provided = iclass_key_iter_skip_source(picopass->key_iter);
         }
-        uint32_t scene_state =
-            scene_manager_get_scene_state(picopass->scene_manager, PicopassSceneEliteDictAttack);
+        IclassKeySource source = picopass->dict_attack_ctx.source;
+        is_key_provided = is_key_provided &&
+                          iclass_key_iter_next(picopass->key_iter, key, &is_elite_key);
+        picopass_elite_dict_attack_update_ctx(picopass);
         memcpy(event.data->req_key.key, key, PICOPASS_KEY_LEN);
-        event.data->req_key.is_elite_key =
-            (scene_state != PicopassSceneEliteDictAttackDictStandard);
+        event.data->req_key.is_elite_key = is_elite_key;
         event.data->req_key.is_key_provided = is_key_provided;
         if(is_key_provided) {
-            picopass->dict_attack_ctx.current_key++;
-            if(picopass->dict_attack_ctx.current_key %
-                   PICOPASS_SCENE_DICT_ATTACK_KEYS_BATCH_UPDATE ==
-               0) {
+            if(picopass->dict_attack_ctx.source != source ||
+               picopass->dict_attack_ctx.current_key %
+                       PICOPASS_SCENE_DICT_ATTACK_KEYS_BATCH_UPDATE ==
+                   0) {
+                iclass_attack_telemetry_update(
+                    &picopass->dict_attack_ctx.telemetry, picopass->poller);
                 view_dispatcher_send_custom_event(
                     picopass->view_dispatcher, PicopassCustomEventDictAttackUpdateView);
             }
         }
+    } else if(event.type == PicopassPollerEventTypeReturnKey) {
+        iclass_key_iter_put_back(
+            picopass->key_iter, event.data->req_key.key, event.data->req_key.is_elite_key);
     } else if(
         event.type == PicopassPollerEventTypeSuccess ||
         event.type == PicopassPollerEventTypeFail ||
         event.type == PicopassPollerEventTypeAuthFail) {
         const PicopassDeviceData* data = picopass_poller_get_data(picopass->poller);
         memcpy(&picopass->dev->dev_data, data, sizeof(PicopassDeviceData));
+        // A key was found or every key was tried. Fail is any read error, the card leaving
+        // included, and keeps the journal for the next attempt.
+        picopass->dict_attack_ctx.attack_done =
+            event.type == PicopassPollerEventTypeAuthFail ||
+            (event.type == PicopassPollerEventTypeSuccess &&
+             data->auth == PicopassDeviceAuthMethodKey);
         view_dispatcher_send_custom_event(
             picopass->view_dispatcher, PicopassCustomEventPollerSuccess);
     } else if(event.type == PicopassPollerEventTypeCardLost) {
@@ -117,6 +132,14 @@ static void picopass_scene_elite_dict_attack_update_view(Picopass* instance) {
             instance->dict_attack, instance->dict_attack_ctx.total_keys);
         dict_attack_set_current_dict_key(
             instance->dict_attack, instance->dict_attack_ctx.current_key);
+        IclassAttackTelemetry* telemetry = &instance->dict_attack_ctx.telemetry;
+        uint32_t keys_left =
+            instance->dict_attack_ctx.total_keys - instance->dict_attack_ctx.current_key;
+        dict_attack_set_speed(
+            instance->dict_attack,
+            iclass_attack_telemetry_get_keys_per_s(telemetry),
+            iclass_attack_telemetry_get_eta(telemetry, keys_left),
+            iclass_attack_telemetry_get_rf_percent(telemetry));
     } else {
         dict_attack_set_card_removed(instance->dict_attack);
     }
@@ -134,32 +157,18 @@ void picopass_scene_elite_dict_attack_on_enter(void* context) {
     dolphin_deed(DolphinDeedNfcRead);
 
     // Setup dict attack context
-    uint32_t state = PicopassSceneEliteDictAttackDictEliteUser;
-
-    bool use_user_dict = keys_dict_check_presence(PICOPASS_ICLASS_ELITE_DICT_USER_NAME);
-    if(use_user_dict) {
-        picopass->dict = keys_dict_alloc(
-            PICOPASS_ICLASS_ELITE_DICT_USER_NAME, KeysDictModeOpenExisting, PICOPASS_KEY_LEN);
-        if(keys_dict_get_total_keys(picopass->dict) == 0) {
-            keys_dict_free(picopass->dict);
-            use_user_dict = false;
-        }
-    }
-    if(use_user_dict) {
-        state = PicopassSceneEliteDictAttackDictEliteUser;
-    } else {
-        picopass->dict = keys_dict_alloc(
-            PICOPASS_ICLASS_STANDARD_DICT_FLIPPER_NAME,
-            KeysDictModeOpenExisting,
-            PICOPASS_KEY_LEN);
-        state = PicopassSceneEliteDictAttackDictStandard;
-    }
+    picopass->key_iter = iclass_key_iter_alloc(
+        picopass_dict_attack_sources, COUNT_OF(picopass_dict_attack_sources));
     dict_attack_reset(picopass->dict_attack);
     picopass->dict_attack_ctx.card_detected = false;
-    picopass->dict_attack_ctx.total_keys = keys_dict_get_total_keys(picopass->dict);
+    picopass->dict_attack_ctx.skip_source = false;
+    picopass->dict_attack_ctx.csn_valid = false;
+    picopass->dict_attack_ctx.attack_done = false;
+    picopass->dict_attack_ctx.source = IclassKeySourceEliteDict;
+    picopass->dict_attack_ctx.name = picopass_dict_name[IclassKeySourceEliteDict];
+    picopass->dict_attack_ctx.total_keys = 0;
     picopass->dict_attack_ctx.current_key = 0;
-    picopass->dict_attack_ctx.name = picopass_dict_name[state];
-    scene_manager_set_scene_state(picopass->scene_manager, PicopassSceneEliteDictAttack, state);
+    picopass_elite_dict_attack_update_ctx(picopass);
 
     // Setup view
     picopass_scene_elite_dict_attack_update_view(picopass);
@@ -167,7 +176,9 @@ void picopass_scene_elite_dict_attack_on_enter(void* context) {
         picopass->dict_attack, picopass_scene_elite_dict_attack_callback, picopass);
 
     // Start worker
+    iclass_attack_telemetry_start(&picopass->dict_attack_ctx.telemetry);
     picopass->poller = picopass_poller_alloc(picopass->nfc);
+    picopass_poller_set_detect_config(picopass->poller, &picopass_dict_attack_detect_config);
     picopass_poller_start(picopass->poller, picopass_elite_dict_attack_worker_callback, picopass);
 
     view_dispatcher_switch_to_view(picopass->view_dispatcher, PicopassViewDictAttack);
@@ -181,6 +192,10 @@ bool picopass_scene_elite_dict_attack_on_event(void* context, SceneManagerEvent
 
     if(event.type == SceneManagerEventTypeCustom) {
         if(event.event == PicopassCustomEventPollerSuccess) {
+            if(auth == PicopassDeviceAuthMethodKey) {
+                iclass_key_hits_record(
+                    picopass->dev->dev_data.pacs.key, picopass->dev->dev_data.pacs.elite_kdf);
+            }
             if(memcmp(
                    picopass->dev->dev_data.pacs.key,
                    picopass_factory_debit_key,
@@ -227,11 +242,8 @@ bool picopass_scene_elite_dict_attack_on_event(void* context, SceneManagerEvent
             picopass_scene_elite_dict_attack_update_view(picopass);
             consumed = true;
         } else if(event.event == PicopassCustomEventDictAttackSkip) {
-            uint32_t scene_state = scene_manager_get_scene_state(
-                picopass->scene_manager, PicopassSceneEliteDictAttack);
-            if(scene_state != PicopassSceneEliteDictAttackDictElite) {
-                picopass_elite_dict_attack_change_dict(picopass);
-                picopass_scene_elite_dict_attack_update_view(picopass);
+            if(picopass->dict_attack_ctx.source != IclassKeySourceEliteDict) {
+                picopass->dict_attack_ctx.skip_source = true;
             } else {
                 if(memcmp(
                        picopass->dev->dev_data.pacs.key,
@@ -253,22 +265,33 @@ bool picopass_scene_elite_dict_attack_on_event(void* context, SceneManagerEvent
 void picopass_scene_elite_dict_attack_on_exit(void* context) {
     Picopass* picopass = context;
 
-    if(picopass->dict) {
-        keys_dict_free(picopass->dict);
-        picopass->dict = NULL;
-    }
     picopass->dict_attack_ctx.current_key = 0;
     picopass->dict_attack_ctx.total_keys = 0;
 
     picopass_poller_stop(picopass->poller);
+    iclass_attack_telemetry_update(&picopass->dict_attack_ctx.telemetry, picopass->poller);
+    iclass_attack_telemetry_log(
+        &picopass->dict_attack_ctx.telemetry,
+        PICOPASS_SCENE_DICT_ATTACK_JOURNAL,
+        picopass->dict_attack_ctx.attack_done ? "done" : "stopped");
     picopass_poller_free(picopass->poller);
 
+    if(picopass->dict_attack_ctx.csn_valid) {
+        if(picopass->dict_attack_ctx.attack_done) {
+            iclass_attack_journal_remove(
+                PICOPASS_SCENE_DICT_ATTACK_JOURNAL, picopass->dict_attack_ctx.csn);
+        } else {
+            iclass_attack_journal_save(
+                PICOPASS_SCENE_DICT_ATTACK_JOURNAL,
+                picopass->dict_attack_ctx.csn,
+                picopass->key_iter);
+        }
+    }
+    iclass_key_iter_free(picopass->key_iter);
+    picopass->key_iter = NULL;
+
     // Clear view
     popup_reset(picopass->popup);
-    scene_manager_set_scene_state(
-        picopass->scene_manager,
-        PicopassSceneEliteDictAttack,
-        PicopassSceneEliteDictAttackDictEliteUser);
 
     picopass_blink_stop(picopass);
 }
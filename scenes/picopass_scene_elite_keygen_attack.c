@@ -1,9 +1,35 @@
 #include "../picopass_i.h"
 #include <dolphin/dolphin.h>
-#include "../picopass_elite_keygen.h"
 
 #define PICOPASS_SCENE_DICT_ATTACK_KEYS_BATCH_UPDATE (10)
-#define PICOPASS_SCENE_ELITE_KEYGEN_ATTACK_LIMIT     (2000)
+
+#define PICOPASS_SCENE_ELITE_KEYGEN_ATTACK_JOURNAL "keygen"
+
+// Keys are tried for minutes against a card that may slip, find it again fast
+static const PicopassPollerDetectConfig picopass_elite_keygen_attack_detect_config = {
+    .fast_delay_ms = 5,
+    .fast_attempts = 200,
+    .idle_delay_ms = 100,
+};
+
+static const IclassKeySource picopass_elite_keygen_attack_sources[] = {
+    IclassKeySourceKeygen,
+};
+
+static void picopass_elite_keygen_attack_select_card(Picopass* picopass, const uint8_t* csn) {
+    PicopassDictAttackContext* ctx = &picopass->dict_attack_ctx;
+    if(ctx->csn_valid && memcmp(ctx->csn, csn, PICOPASS_BLOCK_LEN) == 0) return;
+
+    if(ctx->csn_valid) {
+        iclass_attack_journal_save(
+            PICOPASS_SCENE_ELITE_KEYGEN_ATTACK_JOURNAL, ctx->csn, picopass->key_iter);
+        iclass_key_iter_reset(picopass->key_iter);
+    }
+    iclass_attack_journal_load(
+        PICOPASS_SCENE_ELITE_KEYGEN_ATTACK_JOURNAL, csn, picopass->key_iter);
+    memcpy(ctx->csn, csn, PICOPASS_BLOCK_LEN);
+    ctx->csn_valid = true;
+}
 
 NfcCommand picopass_elite_keygen_attack_worker_callback(PicopassPollerEvent event, void* context) {
     furi_assert(context);
@@ -15,30 +41,41 @@ NfcCommand picopass_elite_keygen_attack_worker_callback(PicopassPollerEvent even
         event.data->req_mode.mode = PicopassPollerModeRead;
     } else if(event.type == PicopassPollerEventTypeRequestKey) {
         uint8_t key[PICOPASS_KEY_LEN] = {};
-        bool is_key_provided = false;
-        if(picopass->dict_attack_ctx.current_key < PICOPASS_SCENE_ELITE_KEYGEN_ATTACK_LIMIT) {
-            picopass_elite_nextKey(key);
-            is_key_provided = true;
-        }
+        bool is_elite_key = true;
+        const PicopassDeviceData* data = picopass_poller_get_data(picopass->poller);
+        picopass_elite_keygen_attack_select_card(
+            picopass, data->card_data[PICOPASS_CSN_BLOCK_INDEX].data);
+        bool is_key_provided = iclass_key_iter_next(picopass->key_iter, key, &is_elite_key);
 
         memcpy(event.data->req_key.key, key, PICOPASS_KEY_LEN);
-        event.data->req_key.is_elite_key = true;
+        event.data->req_key.is_elite_key = is_elite_key;
         event.data->req_key.is_key_provided = is_key_provided;
         if(is_key_provided) {
-            picopass->dict_attack_ctx.current_key++;
+            picopass->dict_attack_ctx.current_key =
+                iclass_key_iter_get_source_position(picopass->key_iter);
             if(picopass->dict_attack_ctx.current_key %
                    PICOPASS_SCENE_DICT_ATTACK_KEYS_BATCH_UPDATE ==
                0) {
+                iclass_attack_telemetry_update(
+                    &picopass->dict_attack_ctx.telemetry, picopass->poller);
                 view_dispatcher_send_custom_event(
                     picopass->view_dispatcher, PicopassCustomEventDictAttackUpdateView);
             }
         }
+    } else if(event.type == PicopassPollerEventTypeReturnKey) {
+        iclass_key_iter_put_back(
+            picopass->key_iter, event.data->req_key.key, event.data->req_key.is_elite_key);
     } else if(
         event.type == PicopassPollerEventTypeSuccess ||
         event.type == PicopassPollerEventTypeFail ||
         event.type == PicopassPollerEventTypeAuthFail) {
         const PicopassDeviceData* data = picopass_poller_get_data(picopass->poller);
         memcpy(&picopass->dev->dev_data, data, sizeof(PicopassDeviceData));
+        // Only a found key or an exhausted keygen ends the attack, read errors keep the journal
+        picopass->dict_attack_ctx.attack_done =
+            event.type == PicopassPollerEventTypeAuthFail ||
+            (event.type == PicopassPollerEventTypeSuccess &&
+             data->auth == PicopassDeviceAuthMethodKey);
         view_dispatcher_send_custom_event(
             picopass->view_dispatcher, PicopassCustomEventPollerSuccess);
     } else if(event.type == PicopassPollerEventTypeCardLost) {
@@ -59,9 +96,17 @@ static void picopass_scene_elite_keygen_attack_update_view(Picopass* instance) {
         dict_attack_set_card_detected(instance->dict_attack);
         dict_attack_set_header(instance->dict_attack, instance->dict_attack_ctx.name);
         dict_attack_set_total_dict_keys(
-            instance->dict_attack, PICOPASS_SCENE_ELITE_KEYGEN_ATTACK_LIMIT);
+            instance->dict_attack, instance->dict_attack_ctx.total_keys);
         dict_attack_set_current_dict_key(
             instance->dict_attack, instance->dict_attack_ctx.current_key);
+        IclassAttackTelemetry* telemetry = &instance->dict_attack_ctx.telemetry;
+        uint32_t keys_left =
+            instance->dict_attack_ctx.total_keys - instance->dict_attack_ctx.current_key;
+        dict_attack_set_speed(
+            instance->dict_attack,
+            iclass_attack_telemetry_get_keys_per_s(telemetry),
+            iclass_attack_telemetry_get_eta(telemetry, keys_left),
+            iclass_attack_telemetry_get_rf_percent(telemetry));
     } else {
         dict_attack_set_card_removed(instance->dict_attack);
     }
@@ -79,17 +124,16 @@ void picopass_scene_elite_keygen_attack_on_enter(void* context) {
     dolphin_deed(DolphinDeedNfcRead);
 
     // Setup dict attack context
-    uint32_t state = PicopassSceneEliteKeygenAttack;
-
-    picopass->dict = keys_dict_alloc(
-        PICOPASS_ICLASS_STANDARD_DICT_FLIPPER_NAME, KeysDictModeOpenExisting, PICOPASS_KEY_LEN);
+    picopass->key_iter = iclass_key_iter_alloc(
+        picopass_elite_keygen_attack_sources, COUNT_OF(picopass_elite_keygen_attack_sources));
 
     dict_attack_reset(picopass->dict_attack);
     picopass->dict_attack_ctx.card_detected = false;
-    picopass->dict_attack_ctx.total_keys = PICOPASS_SCENE_ELITE_KEYGEN_ATTACK_LIMIT;
+    picopass->dict_attack_ctx.csn_valid = false;
+    picopass->dict_attack_ctx.attack_done = false;
+    picopass->dict_attack_ctx.total_keys = iclass_key_iter_get_source_total(picopass->key_iter);
     picopass->dict_attack_ctx.current_key = 0;
     picopass->dict_attack_ctx.name = "Elite Keygen Attack";
-    scene_manager_set_scene_state(picopass->scene_manager, PicopassSceneEliteKeygenAttack, state);
 
     // Setup view
     picopass_scene_elite_keygen_attack_update_view(picopass);
@@ -97,7 +141,10 @@ void picopass_scene_elite_keygen_attack_on_enter(void* context) {
         picopass->dict_attack, picopass_scene_elite_keygen_attack_callback, picopass);
 
     // Start worker
+    iclass_attack_telemetry_start(&picopass->dict_attack_ctx.telemetry);
     picopass->poller = picopass_poller_alloc(picopass->nfc);
+    picopass_poller_set_detect_config(
+        picopass->poller, &picopass_elite_keygen_attack_detect_config);
     picopass_poller_start(
         picopass->poller, picopass_elite_keygen_attack_worker_callback, picopass);
 
@@ -127,16 +174,29 @@ bool picopass_scene_elite_keygen_attack_on_event(void* context, SceneManagerEven
 void picopass_scene_elite_keygen_attack_on_exit(void* context) {
     Picopass* picopass = context;
 
-    if(picopass->dict) {
-        keys_dict_free(picopass->dict);
-        picopass->dict = NULL;
-    }
     picopass->dict_attack_ctx.current_key = 0;
     picopass->dict_attack_ctx.total_keys = 0;
-    picopass_elite_reset();
 
     picopass_poller_stop(picopass->poller);
+    iclass_attack_telemetry_update(&picopass->dict_attack_ctx.telemetry, picopass->poller);
+    iclass_attack_telemetry_log(
+        &picopass->dict_attack_ctx.telemetry,
+        PICOPASS_SCENE_ELITE_KEYGEN_ATTACK_JOURNAL,
+        picopass->dict_attack_ctx.attack_done ? "done" : "stopped");
     picopass_poller_free(picopass->poller);
+    if(picopass->dict_attack_ctx.csn_valid) {
+        if(picopass->dict_attack_ctx.attack_done) {
+            iclass_attack_journal_remove(
+                PICOPASS_SCENE_ELITE_KEYGEN_ATTACK_JOURNAL, picopass->dict_attack_ctx.csn);
+        } else {
+            iclass_attack_journal_save(
+                PICOPASS_SCENE_ELITE_KEYGEN_ATTACK_JOURNAL,
+                picopass->dict_attack_ctx.csn,
+                picopass->key_iter);
+        }
+    }
+    iclass_key_iter_free(picopass->key_iter);
+    picopass->key_iter = NULL;
 
     // Clear view
     popup_reset(picopass->popup);
@@ -58,11 +58,17 @@ void picopass_scene_loclass_on_enter(void* context) {
     picopass->listener = picopass_listener_alloc(picopass->nfc, data);
     free(data);
     if(picopass_listener_set_mode(picopass->listener, PicopassListenerModeLoclass)) {
+        const LoclassPlan* plan = picopass_listener_get_loclass_plan(picopass->listener);
+        picopass->loclass_context.macs_to_collect = loclass_plan_get_total(plan);
+        loclass_set_macs_to_collect(picopass->loclass, picopass->loclass_context.macs_to_collect);
         picopass_listener_start(
             picopass->listener, picopass_scene_loclass_listener_callback, picopass);
     } else {
-        loclass_set_num_macs(picopass->loclass, 255);
-        loclass_set_header(picopass->loclass, "Error Opening Log File");
+        loclass_set_num_macs(picopass->loclass, LOCLASS_NUM_MACS_NONE);
+        loclass_set_header(
+            picopass->loclass,
+            picopass_listener_get_loclass_plan(picopass->listener) ? "Error Opening Log File" :
+                                                                     "Error Loading Plan");
         picopass_listener_free(picopass->listener);
         picopass->listener = NULL;
     }
@@ -76,7 +82,9 @@ bool picopass_scene_loclass_on_event(void* context, SceneManagerEvent event) {
         if(event.event == PicopassCustomEventLoclassGotMac) {
             notification_message(picopass->notifications, &sequence_single_vibro);
             loclass_set_num_macs(picopass->loclass, picopass->loclass_context.macs_collected);
-            if(picopass->loclass_context.macs_collected >= LOCLASS_MACS_TO_COLLECT) {
+            if(picopass->loclass_context.macs_to_collect &&
+               picopass->loclass_context.macs_collected >=
+                   picopass->loclass_context.macs_to_collect) {
                 notification_message(picopass->notifications, &sequence_double_vibro);
                 scene_manager_previous_scene(picopass->scene_manager);
             }
@@ -88,6 +96,13 @@ bool picopass_scene_loclass_on_event(void* context, SceneManagerEvent event) {
         } else if(event.event == PicopassCustomEventViewExit) {
             consumed = scene_manager_previous_scene(picopass->scene_manager);
         }
+    } else if(event.type == SceneManagerEventTypeTick) {
+        if(picopass->listener) {
+            LoclassWriterStats stats;
+            picopass_listener_get_loclass_stats(picopass->listener, &stats);
+            loclass_set_writer_stats(picopass->loclass, stats.queued, stats.dropped);
+        }
+        consumed = true;
     }
 
     return consumed;
@@ -2,32 +2,11 @@
 #include <dolphin/dolphin.h>
 #include "../picopass_keys.h"
 
-enum {
-    PicopassSceneReadCardDictStandard,
-    PicopassSceneReadCardDictElite,
+static const IclassKeySource picopass_read_card_sources[] = {
+    IclassKeySourceStandardDict,
+    IclassKeySourceEliteDict,
 };
 
-static bool picopass_read_card_change_dict(Picopass* picopass) {
-    bool success = false;
-
-    do {
-        uint32_t scene_state =
-            scene_manager_get_scene_state(picopass->scene_manager, PicopassSceneReadCard);
-        keys_dict_free(picopass->dict);
-        picopass->dict = NULL;
-        if(scene_state == PicopassSceneReadCardDictElite) break;
-        if(!keys_dict_check_presence(PICOPASS_ICLASS_ELITE_DICT_FLIPPER_NAME)) break;
-
-        picopass->dict = keys_dict_alloc(
-            PICOPASS_ICLASS_ELITE_DICT_FLIPPER_NAME, KeysDictModeOpenExisting, PICOPASS_KEY_LEN);
-        scene_manager_set_scene_state(
-            picopass->scene_manager, PicopassSceneReadCard, PicopassSceneReadCardDictElite);
-        success = true;
-    } while(false);
-
-    return success;
-}
-
 NfcCommand picopass_read_card_worker_callback(PicopassPollerEvent event, void* context) {
     furi_assert(context);
     NfcCommand command = NfcCommandContinue;
@@ -38,19 +17,14 @@ NfcCommand picopass_read_card_worker_callback(PicopassPollerEvent event, void* c
         event.data->req_mode.mode = PicopassPollerModeRead;
     } else if(event.type == PicopassPollerEventTypeRequestKey) {
         uint8_t key[PICOPASS_KEY_LEN] = {};
-        bool is_key_provided = true;
-        if(!keys_dict_get_next_key(picopass->dict, key, PICOPASS_KEY_LEN)) {
-            if(picopass_read_card_change_dict(picopass)) {
-                is_key_provided = keys_dict_get_next_key(picopass->dict, key, PICOPASS_KEY_LEN);
-            } else {
-                is_key_provided = false;
-            }
-        }
-        uint32_t scene_state =
-            scene_manager_get_scene_state(picopass->scene_manager, PicopassSceneReadCard);
+        bool is_elite_key = false;
+        bool is_key_provided = iclass_key_iter_next(picopass->key_iter, key, &is_elite_key);
         memcpy(event.data->req_key.key, key, PICOPASS_KEY_LEN);
-        event.data->req_key.is_elite_key = (scene_state == PicopassSceneReadCardDictElite);
+        event.data->req_key.is_elite_key = is_elite_key;
         event.data->req_key.is_key_provided = is_key_provided;
+    } else if(event.type == PicopassPollerEventTypeReturnKey) {
+        iclass_key_iter_put_back(
+            picopass->key_iter, event.data->req_key.key, event.data->req_key.is_elite_key);
     } else if(
         event.type == PicopassPollerEventTypeSuccess ||
         event.type == PicopassPollerEventTypeAuthFail) {
@@ -81,10 +55,8 @@ void picopass_scene_read_card_on_enter(void* context) {
     popup_set_header(popup, "Detecting\npicopass\ncard", 68, 30, AlignLeft, AlignTop);
     popup_set_icon(popup, 0, 3, &I_RFIDDolphinReceive_97x61);
 
-    picopass->dict = keys_dict_alloc(
-        PICOPASS_ICLASS_STANDARD_DICT_FLIPPER_NAME, KeysDictModeOpenExisting, PICOPASS_KEY_LEN);
-    scene_manager_set_scene_state(
-        picopass->scene_manager, PicopassSceneReadCard, PicopassSceneReadCardDictStandard);
+    picopass->key_iter = iclass_key_iter_alloc(
+        picopass_read_card_sources, COUNT_OF(picopass_read_card_sources));
     // Start worker
     picopass->poller = picopass_poller_alloc(picopass->nfc);
     picopass_poller_start(picopass->poller, picopass_read_card_worker_callback, picopass);
@@ -99,6 +71,10 @@ bool picopass_scene_read_card_on_event(void* context, SceneManagerEvent event) {
 
     if(event.type == SceneManagerEventTypeCustom) {
         if(event.event == PicopassCustomEventPollerSuccess) {
+            if(picopass->dev->dev_data.auth == PicopassDeviceAuthMethodKey) {
+                iclass_key_hits_record(
+                    picopass->dev->dev_data.pacs.key, picopass->dev->dev_data.pacs.elite_kdf);
+            }
             if(memcmp(
                    picopass->dev->dev_data.pacs.key,
                    picopass_factory_debit_key,
@@ -116,17 +92,13 @@ bool picopass_scene_read_card_on_event(void* context, SceneManagerEvent event) {
 void picopass_scene_read_card_on_exit(void* context) {
     Picopass* picopass = context;
 
-    if(picopass->dict) {
-        keys_dict_free(picopass->dict);
-        picopass->dict = NULL;
-    }
     picopass_poller_stop(picopass->poller);
     picopass_poller_free(picopass->poller);
+    iclass_key_iter_free(picopass->key_iter);
+    picopass->key_iter = NULL;
 
     // Clear view
     popup_reset(picopass->popup);
-    scene_manager_set_scene_state(
-        picopass->scene_manager, PicopassSceneReadCard, PicopassSceneReadCardDictStandard);
 
     picopass_blink_stop(picopass);
 }
@@ -10,6 +10,7 @@ enum SubmenuIndex {
     SubmenuIndexSaveAsLF,
     SubmenuIndexSaveLegacy,
     SubmenuIndexSaveAsSeader,
+    SubmenuIndexReRead,
 };
 
 void picopass_scene_saved_menu_submenu_callback(void* context, uint32_t index) {
@@ -83,6 +84,12 @@ void picopass_scene_saved_menu_on_enter(void* context) {
     }
 
     if(is_saved) {
+        submenu_add_item(
+            submenu,
+            "Check for Changes",
+            SubmenuIndexReRead,
+            picopass_scene_saved_menu_submenu_callback,
+            picopass);
         submenu_add_item(
             submenu,
             "Rename",
@@ -130,6 +137,9 @@ bool picopass_scene_saved_menu_on_event(void* context, SceneManagerEvent event)
             picopass->dev->format = PicopassDeviceSaveFormatOriginal;
             scene_manager_next_scene(picopass->scene_manager, PicopassSceneSaveName);
             consumed = true;
+        } else if(event.event == SubmenuIndexReRead) {
+            scene_manager_next_scene(picopass->scene_manager, PicopassSceneDeltaRead);
+            consumed = true;
         } else if(event.event == SubmenuIndexRename) {
             scene_manager_next_scene(picopass->scene_manager, PicopassSceneSaveName);
             consumed = true;
@@ -9,6 +9,8 @@ enum SubmenuIndex {
     SubmenuIndexNRMAC,
     SubmenuIndexAcknowledgements,
     SubmenuIndexKeygenAttack,
+    SubmenuIndexBatchRead,
+    SubmenuIndexCalibrateTiming,
 };
 
 void picopass_scene_start_submenu_callback(void* context, uint32_t index) {
@@ -23,6 +25,12 @@ void picopass_scene_start_on_enter(void* context) {
     Submenu* submenu = picopass->submenu;
     submenu_add_item(
         submenu, "Read Card", SubmenuIndexRead, picopass_scene_start_submenu_callback, picopass);
+    submenu_add_item(
+        submenu,
+        "Batch Read",
+        SubmenuIndexBatchRead,
+        picopass_scene_start_submenu_callback,
+        picopass);
     submenu_add_item(
         submenu, "Saved", SubmenuIndexSaved, picopass_scene_start_submenu_callback, picopass);
     submenu_add_item(
@@ -45,6 +53,12 @@ void picopass_scene_start_on_enter(void* context) {
         SubmenuIndexKeygenAttack,
         picopass_scene_start_submenu_callback,
         picopass);
+    submenu_add_item(
+        submenu,
+        "Calibrate Timing",
+        SubmenuIndexCalibrateTiming,
+        picopass_scene_start_submenu_callback,
+        picopass);
 
     submenu_set_selected_item(
         submenu, scene_manager_get_scene_state(picopass->scene_manager, PicopassSceneStart));
@@ -95,6 +109,16 @@ bool picopass_scene_start_on_event(void* context, SceneManagerEvent event) {
                 picopass->scene_manager, PicopassSceneStart, SubmenuIndexKeygenAttack);
             scene_manager_next_scene(picopass->scene_manager, PicopassSceneEliteKeygenAttack);
             consumed = true;
+        } else if(event.event == SubmenuIndexBatchRead) {
+            scene_manager_set_scene_state(
+                picopass->scene_manager, PicopassSceneStart, SubmenuIndexBatchRead);
+            scene_manager_next_scene(picopass->scene_manager, PicopassSceneBatchRead);
+            consumed = true;
+        } else if(event.event == SubmenuIndexCalibrateTiming) {
+            scene_manager_set_scene_state(
+                picopass->scene_manager, PicopassSceneStart, SubmenuIndexCalibrateTiming);
+            scene_manager_next_scene(picopass->scene_manager, PicopassSceneCalibrateTiming);
+            consumed = true;
         }
     }
 
@@ -0,0 +1,691 @@
+// Host-side offline key search: finds which dictionary, keygen or raw key opens a card from
+// captured reader MACs, without the card.
+//
+// Build from the repository root:
+//   cc -O3 -pthread -I. -Ilib/loclass -o iclass_crack tools/iclass_crack.c tools/loclass_reader.c
+//      picopass_elite_keygen.c lib/loclass/*.c
+//
+// Usage: iclass_crack [-t threads] [-d dict] [-e dict] [-k [first:]count] [-r start:count]
+//                     <capture>...
+//
+// Captures are .mac files saved by the NR-MAC listener (<csn>_<epurse>.mac), .loclass.log or
+// .loclass.bin. Every key source is tried against every CSN in them:
+//   -d  dictionary of keys used with the standard KDF (.txt or compiled .bin)
+//   -e  dictionary of keys used with the elite KDF
+//   -k  picopass_elite_keygen keys, elite KDF
+//   -r  every 64 bit key from start (hex), with both KDFs. DES ignores the low bit of each key
+//       byte, so the key reported can differ from the card's in those bits and still work.
+// Without any of them the dictionaries in files/ and the 2000 keygen keys the app uses are tried.
+//
+// Sources are cut into chunks and each worker starts with an equal share of them. A worker that
+// runs out steals chunks from whoever has the most left, so a slow core or an expensive elite
+// source doesn't leave the rest idle, and a worker keeps walking its own share in order, which
+// lets it step the keygen instead of seeking it for every chunk.
+
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "optimized_cipher.h"
+#include "optimized_elite.h"
+#include "optimized_ikeys.h"
+#include "picopass_elite_keygen.h"
+#include "loclass_reader.h"
+
+#define ICLASS_CRACK_MAX_THREADS 256
+#define ICLASS_CRACK_MAX_SOURCES 32
+#define ICLASS_CRACK_MAX_TARGETS 64
+#define ICLASS_CRACK_MAX_MACS    16
+#define ICLASS_CRACK_CHUNK       4096
+#define ICLASS_CRACK_POLL_US     (20 * 1000)
+#define ICLASS_CRACK_REPORT_S    1.0
+#define ICLASS_CRACK_KEY_LEN     8
+#define ICLASS_CRACK_KEYGEN_KEYS 2000
+
+#define ICLASS_CRACK_DICT_MAGIC  "PICODICT"
+#define ICLASS_CRACK_DICT_HEADER 16
+
+typedef enum {
+    IclassCrackSourceDict,
+    IclassCrackSourceKeygen,
+    IclassCrackSourceRange,
+} IclassCrackSourceType;
+
+typedef struct {
+    IclassCrackSourceType type;
+    char name[64];
+    bool elite;
+    uint8_t* keys;
+    uint64_t first;
+    uint64_t count;
+    uint64_t first_chunk;
+} IclassCrackSource;
+
+typedef struct {
+    uint8_t cc_nr[12];
+    uint8_t mac[4];
+} IclassCrackMac;
+
+typedef struct {
+    uint8_t csn[8];
+    uint8_t key_index[8];
+    IclassCrackMac macs[ICLASS_CRACK_MAX_MACS];
+    size_t num_macs;
+
+    atomic_bool found;
+    uint8_t key[ICLASS_CRACK_KEY_LEN];
+    bool elite;
+    const IclassCrackSource* source;
+    uint64_t source_index;
+} IclassCrackTarget;
+
+typedef struct IclassCrack IclassCrack;
+
+// One cache line each, every worker bumps its own counters all the time
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t next;
+    uint64_t end;
+    atomic_uint_fast64_t tested;
+    uint64_t stolen;
+    double busy;
+    pthread_t thread;
+    IclassCrack* crack;
+} IclassCrackWorker;
+
+struct IclassCrack {
+    IclassCrackSource sources[ICLASS_CRACK_MAX_SOURCES];
+    size_t num_sources;
+    uint64_t num_chunks;
+
+    IclassCrackTarget targets[ICLASS_CRACK_MAX_TARGETS];
+    size_t num_targets;
+    atomic_size_t remaining;
+    pthread_mutex_t found_lock;
+
+    IclassCrackWorker workers[ICLASS_CRACK_MAX_THREADS];
+    size_t num_workers;
+};
+
+static double iclass_crack_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool iclass_crack_parse_hex(const char* hex, uint8_t* out, size_t len) {
+    if(strlen(hex) != len * 2) return false;
+    for(size_t i = 0; i < len; i++) {
+        unsigned int byte;
+        if(sscanf(hex + i * 2, "%2x", &byte) != 1) return false;
+        out[i] = byte;
+    }
+    return true;
+}
+
+static void iclass_crack_print_hex(const uint8_t* data, size_t len) {
+    for(size_t i = 0; i < len; i++) printf("%02X", data[i]);
+}
+
+static void
+    iclass_crack_add_mac(IclassCrack* crack, const uint8_t csn[8], const IclassCrackMac* mac) {
+    IclassCrackTarget* target = NULL;
+    for(size_t i = 0; i < crack->num_targets; i++) {
+        if(memcmp(crack->targets[i].csn, csn, 8) == 0) {
+            target = &crack->targets[i];
+            break;
+        }
+    }
+    if(!target) {
+        if(crack->num_targets == ICLASS_CRACK_MAX_TARGETS) return;
+        target = &crack->targets[crack->num_targets++];
+        memcpy(target->csn, csn, 8);
+        loclass_hash1(csn, target->key_index);
+    }
+
+    for(size_t i = 0; i < target->num_macs; i++) {
+        if(memcmp(&target->macs[i], mac, sizeof(*mac)) == 0) return;
+    }
+    if(target->num_macs < ICLASS_CRACK_MAX_MACS) {
+        target->macs[target->num_macs++] = *mac;
+    }
+}
+
+// <csn>_<epurse>.mac holding "NR-MAC: xx xx xx xx xx xx xx xx"
+static bool iclass_crack_load_mac(IclassCrack* crack, const char* path) {
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    char csn_hex[17], epurse_hex[17];
+    uint8_t csn[8];
+    IclassCrackMac mac;
+    if(sscanf(name, "%16[0-9a-fA-F]_%16[0-9a-fA-F].mac", csn_hex, epurse_hex) != 2 ||
+       !iclass_crack_parse_hex(csn_hex, csn, 8) ||
+       !iclass_crack_parse_hex(epurse_hex, mac.cc_nr, 8)) {
+        fprintf(stderr, "%s: name is not <csn>_<epurse>.mac\n", path);
+        return false;
+    }
+
+    FILE* file = fopen(path, "r");
+    if(!file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    bool loaded = false;
+    char line[128];
+    while(!loaded && fgets(line, sizeof(line), file)) {
+        unsigned int b[8];
+        if(sscanf(
+               line,
+               "NR-MAC: %x %x %x %x %x %x %x %x",
+               &b[0],
+               &b[1],
+               &b[2],
+               &b[3],
+               &b[4],
+               &b[5],
+               &b[6],
+               &b[7]) != 8) {
+            continue;
+        }
+        for(size_t i = 0; i < 4; i++) {
+            mac.cc_nr[8 + i] = b[i];
+            mac.mac[i] = b[4 + i];
+        }
+        iclass_crack_add_mac(crack, csn, &mac);
+        loaded = true;
+    }
+    fclose(file);
+
+    if(!loaded) fprintf(stderr, "%s: no NR-MAC line\n", path);
+    return loaded;
+}
+
+static bool iclass_crack_load_loclass_log(IclassCrack* crack, const char* path) {
+    FILE* file = fopen(path, "r");
+    if(!file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    size_t num_lines = 0;
+    char line[256];
+    while(fgets(line, sizeof(line), file)) {
+        char csn_hex[17], cc_hex[17], nr_hex[9], mac_hex[9];
+        unsigned long ts;
+        unsigned int log_no;
+        uint8_t csn[8];
+        IclassCrackMac mac;
+        if(sscanf(
+               line,
+               "loclass-v1-mac ts %lu no %u csn %16s cc %16s nr %8s mac %8s",
+               &ts,
+               &log_no,
+               csn_hex,
+               cc_hex,
+               nr_hex,
+               mac_hex) != 6 ||
+           !iclass_crack_parse_hex(csn_hex, csn, 8) ||
+           !iclass_crack_parse_hex(cc_hex, mac.cc_nr, 8) ||
+           !iclass_crack_parse_hex(nr_hex, mac.cc_nr + 8, 4) ||
+           !iclass_crack_parse_hex(mac_hex, mac.mac, 4)) {
+            continue;
+        }
+        iclass_crack_add_mac(crack, csn, &mac);
+        num_lines++;
+    }
+    fclose(file);
+
+    return num_lines > 0;
+}
+
+static bool iclass_crack_load_loclass_bin(IclassCrack* crack, const char* path) {
+    LoclassReader* reader = loclass_reader_open(path);
+    if(!reader) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    size_t num_records = 0;
+    LoclassReaderEntry entry;
+    while(loclass_reader_next(reader, &entry)) {
+        if(!entry.csn) continue;
+        IclassCrackMac mac;
+        memcpy(mac.cc_nr, entry.record->epurse, 8);
+        memcpy(mac.cc_nr + 8, entry.record->nr, 4);
+        memcpy(mac.mac, entry.record->mac, 4);
+        iclass_crack_add_mac(crack, entry.csn, &mac);
+        num_records++;
+    }
+    loclass_reader_close(reader);
+
+    return num_records > 0;
+}
+
+static bool iclass_crack_load_capture(IclassCrack* crack, const char* path) {
+    size_t len = strlen(path);
+    if(len > 4 && strcmp(path + len - 4, ".mac") == 0) return iclass_crack_load_mac(crack, path);
+    if(loclass_reader_probe(path)) return iclass_crack_load_loclass_bin(crack, path);
+    return iclass_crack_load_loclass_log(crack, path);
+}
+
+static IclassCrackSource* iclass_crack_add_source(
+    IclassCrack* crack,
+    IclassCrackSourceType type,
+    bool elite,
+    const char* name) {
+    if(crack->num_sources == ICLASS_CRACK_MAX_SOURCES) {
+        fprintf(stderr, "more than %d key sources\n", ICLASS_CRACK_MAX_SOURCES);
+        return NULL;
+    }
+    IclassCrackSource* source = &crack->sources[crack->num_sources++];
+    memset(source, 0, sizeof(IclassCrackSource));
+    source->type = type;
+    source->elite = elite;
+    snprintf(source->name, sizeof(source->name), "%s", name);
+    return source;
+}
+
+// Compiled .bin dictionaries, or the same text rules as tools/iclass_dict_compile.py
+static bool iclass_crack_add_dict(IclassCrack* crack, const char* path, bool elite) {
+    FILE* file = fopen(path, "rb");
+    if(!file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    uint8_t* keys = NULL;
+    uint64_t count = 0;
+    uint8_t header[ICLASS_CRACK_DICT_HEADER];
+    if(fread(header, 1, sizeof(header), file) == sizeof(header) &&
+       memcmp(header, ICLASS_CRACK_DICT_MAGIC, 8) == 0) {
+        uint32_t total = header[12] | header[13] << 8 | header[14] << 16 |
+                         (uint32_t)header[15] << 24;
+        keys = malloc((size_t)total * ICLASS_CRACK_KEY_LEN + 1);
+        count = fread(keys, ICLASS_CRACK_KEY_LEN, total, file);
+    } else {
+        rewind(file);
+        size_t capacity = 1024;
+        keys = malloc(capacity * ICLASS_CRACK_KEY_LEN);
+        char line[64];
+        while(fgets(line, sizeof(line), file)) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if(line[0] == '#') continue;
+            if(count == capacity) {
+                capacity *= 2;
+                keys = realloc(keys, capacity * ICLASS_CRACK_KEY_LEN);
+            }
+            if(iclass_crack_parse_hex(line, keys + count * ICLASS_CRACK_KEY_LEN, 8)) count++;
+        }
+    }
+    fclose(file);
+
+    IclassCrackSource* source = iclass_crack_add_source(crack, IclassCrackSourceDict, elite, path);
+    if(!source) {
+        free(keys);
+        return false;
+    }
+    source->keys = keys;
+    source->count = count;
+    return true;
+}
+
+static bool iclass_crack_parse_span(const char* arg, uint64_t* first, uint64_t* count, int base) {
+    char* end;
+    const char* colon = strchr(arg, ':');
+    *first = 0;
+    if(colon) {
+        *first = strtoull(arg, &end, base);
+        if(end != colon) return false;
+        arg = colon + 1;
+    }
+    *count = strtoull(arg, &end, 0);
+    return *end == '\0' && *count > 0;
+}
+
+static void iclass_crack_source_key(
+    const IclassCrackSource* source,
+    uint64_t index,
+    PicopassEliteKeygen* keygen,
+    uint8_t* key) {
+    if(source->type == IclassCrackSourceDict) {
+        memcpy(key, source->keys + index * ICLASS_CRACK_KEY_LEN, ICLASS_CRACK_KEY_LEN);
+    } else if(source->type == IclassCrackSourceKeygen) {
+        picopass_elite_keygen_next_key(keygen, key);
+    } else {
+        uint64_t value = source->first + index;
+        for(size_t i = 0; i < ICLASS_CRACK_KEY_LEN; i++) {
+            key[i] = value >> (8 * (ICLASS_CRACK_KEY_LEN - 1 - i));
+        }
+    }
+}
+
+static bool iclass_crack_check_macs(const IclassCrackTarget* target, const uint8_t div_key[8]) {
+    for(size_t i = 1; i < target->num_macs; i++) {
+        IclassCrackMac mac = target->macs[i];
+        uint8_t key[8];
+        uint8_t calculated[4];
+        memcpy(key, div_key, 8);
+        loclass_opt_doReaderMAC(mac.cc_nr, key, calculated);
+        if(memcmp(calculated, mac.mac, 4) != 0) return false;
+    }
+    return true;
+}
+
+static void iclass_crack_found(
+    IclassCrack* crack,
+    IclassCrackTarget* target,
+    const IclassCrackSource* source,
+    uint64_t index,
+    const uint8_t* key) {
+    pthread_mutex_lock(&crack->found_lock);
+    if(!atomic_load(&target->found)) {
+        memcpy(target->key, key, ICLASS_CRACK_KEY_LEN);
+        target->elite = source->elite;
+        target->source = source;
+        target->source_index = index;
+        atomic_store(&target->found, true);
+        atomic_fetch_sub(&crack->remaining, 1);
+    }
+    pthread_mutex_unlock(&crack->found_lock);
+}
+
+// Tests keys[0..num_keys) from source, the first at index, against every target still open
+static void iclass_crack_test_batch(
+    IclassCrack* crack,
+    const IclassCrackSource* source,
+    uint64_t index,
+    const uint8_t* keys,
+    size_t num_keys) {
+    static _Thread_local uint8_t keytables[LOCLASS_OPT_MULTI_KEYS][LOCLASS_ELITE_KEYTABLE_LEN];
+    uint8_t sel_keys[LOCLASS_OPT_MULTI_KEYS * 8];
+    uint8_t div_keys[LOCLASS_OPT_MULTI_KEYS * 8];
+
+    // hash2 only depends on the key, so it is paid once per key whatever the number of CSNs
+    if(source->elite) {
+        for(size_t i = 0; i < num_keys; i++) {
+            loclass_elite_keytable_prepare(keys + i * 8, keytables[i]);
+        }
+    }
+
+    for(size_t t = 0; t < crack->num_targets; t++) {
+        IclassCrackTarget* target = &crack->targets[t];
+        if(atomic_load(&target->found)) continue;
+
+        const uint8_t* div_input = keys;
+        if(source->elite) {
+            for(size_t i = 0; i < num_keys; i++) {
+                uint8_t key_sel[8];
+                for(size_t j = 0; j < 8; j++) key_sel[j] = keytables[i][target->key_index[j]];
+                loclass_permutekey_rev(key_sel, sel_keys + i * 8);
+            }
+            div_input = sel_keys;
+        }
+        loclass_diversifyKey_batch(target->csn, div_input, num_keys, div_keys);
+
+        LoclassLanes_t hits = loclass_opt_checkReaderMAC_multi(
+            target->macs[0].cc_nr, div_keys, num_keys, target->macs[0].mac);
+        for(size_t lane = 0; hits; lane++, hits >>= 1) {
+            // The first MAC only has 32 bits, the others weed out false positives
+            if(!(hits & 1) || !iclass_crack_check_macs(target, div_keys + lane * 8)) continue;
+            iclass_crack_found(crack, target, source, index + lane, keys + lane * 8);
+            break;
+        }
+    }
+}
+
+// Own chunks first, then the worker with the most left
+static bool iclass_crack_claim(IclassCrack* crack, IclassCrackWorker* self, uint64_t* chunk) {
+    uint64_t own = atomic_fetch_add(&self->next, 1);
+    if(own < self->end) {
+        *chunk = own;
+        return true;
+    }
+
+    for(;;) {
+        IclassCrackWorker* victim = NULL;
+        uint64_t most_left = 0;
+        for(size_t i = 0; i < crack->num_workers; i++) {
+            IclassCrackWorker* worker = &crack->workers[i];
+            uint64_t next = atomic_load(&worker->next);
+            if(next < worker->end && worker->end - next > most_left) {
+                most_left = worker->end - next;
+                victim = worker;
+            }
+        }
+        if(!victim) return false;
+
+        uint64_t stolen = atomic_fetch_add(&victim->next, 1);
+        if(stolen < victim->end) {
+            self->stolen++;
+            *chunk = stolen;
+            return true;
+        }
+    }
+}
+
+static const IclassCrackSource* iclass_crack_chunk_source(IclassCrack* crack, uint64_t chunk) {
+    const IclassCrackSource* source = &crack->sources[0];
+    for(size_t i = 1; i < crack->num_sources && crack->sources[i].first_chunk <= chunk; i++) {
+        source = &crack->sources[i];
+    }
+    return source;
+}
+
+static void* iclass_crack_worker(void* context) {
+    IclassCrackWorker* self = context;
+    IclassCrack* crack = self->crack;
+    PicopassEliteKeygen keygen;
+    const IclassCrackSource* keygen_source = NULL;
+    uint64_t keygen_next = 0;
+    uint8_t keys[LOCLASS_OPT_MULTI_KEYS * 8];
+
+    double start = iclass_crack_now();
+    uint64_t chunk;
+    while(atomic_load(&crack->remaining) > 0 && iclass_crack_claim(crack, self, &chunk)) {
+        const IclassCrackSource* source = iclass_crack_chunk_source(crack, chunk);
+        uint64_t first = (chunk - source->first_chunk) * ICLASS_CRACK_CHUNK;
+        uint64_t end = first + ICLASS_CRACK_CHUNK;
+        if(end > source->count) end = source->count;
+
+        // Only a stolen chunk or a new source moves the keygen anywhere but the next key
+        if(source->type == IclassCrackSourceKeygen &&
+           (keygen_source != source || keygen_next != first)) {
+            picopass_elite_keygen_seek(
+                &keygen, (source->first + first) % PICOPASS_ELITE_KEYGEN_PERIOD);
+            keygen_source = source;
+        }
+
+        for(uint64_t index = first; index < end && atomic_load(&crack->remaining) > 0;) {
+            size_t num_keys = 0;
+            for(; num_keys < LOCLASS_OPT_MULTI_KEYS && index + num_keys < end; num_keys++) {
+                iclass_crack_source_key(source, index + num_keys, &keygen, keys + num_keys * 8);
+            }
+            iclass_crack_test_batch(crack, source, index, keys, num_keys);
+            atomic_fetch_add(&self->tested, num_keys);
+            index += num_keys;
+            keygen_next = index;
+        }
+    }
+    self->busy = iclass_crack_now() - start;
+
+    return NULL;
+}
+
+static void iclass_crack_usage(const char* name) {
+    fprintf(
+        stderr,
+        "usage: %s [-t threads] [-d dict] [-e dict] [-k [first:]count] [-r start:count] "
+        "<capture>...\n",
+        name);
+}
+
+static uint64_t iclass_crack_tested(IclassCrack* crack) {
+    uint64_t tested = 0;
+    for(size_t i = 0; i < crack->num_workers; i++) {
+        tested += atomic_load(&crack->workers[i].tested);
+    }
+    return tested;
+}
+
+int main(int argc, char* argv[]) {
+    static IclassCrack crack;
+    long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    bool sources_given = false;
+    int opt;
+    while((opt = getopt(argc, argv, "t:d:e:k:r:")) != -1) {
+        uint64_t first, count;
+        IclassCrackSource* source = NULL;
+        bool valid = true;
+        if(opt == 't') {
+            num_threads = strtol(optarg, NULL, 0);
+            continue;
+        }
+        sources_given = true;
+        if(opt == 'd' || opt == 'e') {
+            valid = iclass_crack_add_dict(&crack, optarg, opt == 'e');
+        } else if(opt == 'k') {
+            valid = iclass_crack_parse_span(optarg, &first, &count, 0) &&
+                    count <= PICOPASS_ELITE_KEYGEN_PERIOD &&
+                    (source = iclass_crack_add_source(
+                         &crack, IclassCrackSourceKeygen, true, "elite keygen"));
+            if(source) {
+                source->first = first % PICOPASS_ELITE_KEYGEN_PERIOD;
+                source->count = count;
+            }
+        } else if(opt == 'r') {
+            valid = iclass_crack_parse_span(optarg, &first, &count, 16);
+            for(size_t elite = 0; valid && elite < 2; elite++) {
+                source = iclass_crack_add_source(
+                    &crack, IclassCrackSourceRange, elite, elite ? "range, elite" : "range");
+                valid = source != NULL;
+                if(source) {
+                    source->first = first;
+                    source->count = count;
+                }
+            }
+        } else {
+            valid = false;
+        }
+        if(!valid) {
+            iclass_crack_usage(argv[0]);
+            return 1;
+        }
+    }
+    if(optind == argc || num_threads < 1 || num_threads > ICLASS_CRACK_MAX_THREADS) {
+        iclass_crack_usage(argv[0]);
+        return 1;
+    }
+
+    if(!sources_given) {
+        iclass_crack_add_dict(&crack, "files/iclass_standard_dict.txt", false);
+        iclass_crack_add_dict(&crack, "files/iclass_elite_dict.txt", true);
+        IclassCrackSource* source =
+            iclass_crack_add_source(&crack, IclassCrackSourceKeygen, true, "elite keygen");
+        source->count = ICLASS_CRACK_KEYGEN_KEYS;
+    }
+
+    for(int i = optind; i < argc; i++) {
+        iclass_crack_load_capture(&crack, argv[i]);
+    }
+    if(crack.num_targets == 0) {
+        fprintf(stderr, "no reader MACs in the captures\n");
+        return 1;
+    }
+
+    uint64_t total_keys = 0;
+    for(size_t i = 0; i < crack.num_sources; i++) {
+        IclassCrackSource* source = &crack.sources[i];
+        source->first_chunk = crack.num_chunks;
+        crack.num_chunks += (source->count + ICLASS_CRACK_CHUNK - 1) / ICLASS_CRACK_CHUNK;
+        total_keys += source->count;
+        printf("%-40s %10" PRIu64 " keys\n", source->name, source->count);
+    }
+    printf(
+        "%zu CSNs, %" PRIu64 " keys, %ld worker threads, %zu keys per MAC batch\n",
+        crack.num_targets,
+        total_keys,
+        num_threads,
+        LOCLASS_OPT_MULTI_KEYS);
+
+    atomic_store(&crack.remaining, crack.num_targets);
+    pthread_mutex_init(&crack.found_lock, NULL);
+    crack.num_workers = num_threads;
+    for(size_t i = 0; i < crack.num_workers; i++) {
+        IclassCrackWorker* worker = &crack.workers[i];
+        worker->crack = &crack;
+        atomic_store(&worker->next, crack.num_chunks * i / crack.num_workers);
+        worker->end = crack.num_chunks * (i + 1) / crack.num_workers;
+    }
+
+    double start = iclass_crack_now();
+    for(size_t i = 0; i < crack.num_workers; i++) {
+        pthread_create(&crack.workers[i].thread, NULL, iclass_crack_worker, &crack.workers[i]);
+    }
+
+    // Progress, until the keys run out or every CSN has its key
+    double last_report = start;
+    uint64_t tested = 0;
+    while(atomic_load(&crack.remaining) > 0 &&
+          (tested = iclass_crack_tested(&crack)) < total_keys) {
+        usleep(ICLASS_CRACK_POLL_US);
+        if(iclass_crack_now() - last_report < ICLASS_CRACK_REPORT_S) continue;
+        last_report = iclass_crack_now();
+        double rate = tested / (last_report - start);
+        printf(
+            "  %" PRIu64 "/%" PRIu64 " tested, %.0f keys/s, ETA %.0fs\n",
+            tested,
+            total_keys,
+            rate,
+            rate > 0 ? (total_keys - tested) / rate : 0.0);
+    }
+    for(size_t i = 0; i < crack.num_workers; i++) {
+        pthread_join(crack.workers[i].thread, NULL);
+    }
+
+    double elapsed = iclass_crack_now() - start;
+    tested = iclass_crack_tested(&crack);
+    printf("%" PRIu64 " keys in %.2fs (%.0f keys/s)\n", tested, elapsed, tested / elapsed);
+    for(size_t i = 0; i < crack.num_workers; i++) {
+        IclassCrackWorker* worker = &crack.workers[i];
+        uint64_t worker_tested = atomic_load(&worker->tested);
+        printf(
+            "  worker %zu: %" PRIu64 " keys, %.0f keys/s, %" PRIu64 " chunks stolen\n",
+            i,
+            worker_tested,
+            worker->busy > 0 ? worker_tested / worker->busy : 0.0,
+            worker->stolen);
+    }
+
+    size_t found = 0;
+    for(size_t i = 0; i < crack.num_targets; i++) {
+        IclassCrackTarget* target = &crack.targets[i];
+        printf("CSN ");
+        iclass_crack_print_hex(target->csn, 8);
+        if(atomic_load(&target->found)) {
+            printf(": key ");
+            iclass_crack_print_hex(target->key, ICLASS_CRACK_KEY_LEN);
+            printf(
+                " (%s KDF) from %s, key %" PRIu64 "\n",
+                target->elite ? "elite" : "standard",
+                target->source->name,
+                target->source->first + target->source_index);
+            found++;
+        } else {
+            printf(": not found\n");
+        }
+    }
+
+    pthread_mutex_destroy(&crack.found_lock);
+    for(size_t i = 0; i < crack.num_sources; i++) {
+        free(crack.sources[i].keys);
+    }
+    return found == crack.num_targets ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""Compile an iClass key dictionary (.txt) into the packed .bin read by helpers/iclass_elite_dict.c
+
+Run by fbt through fap_extbuild in application.fam, or by hand:
+    python3 tools/iclass_dict_compile.py files/iclass_elite_dict.txt files/iclass_elite_dict.bin
+
+Layout, little endian:
+    char     magic[8]    "PICODICT"
+    uint16_t version     1
+    uint16_t key_len     8
+    uint32_t total_keys
+    uint8_t  keys[total_keys][8]
+"""
+
+import struct
+import sys
+
+MAGIC = b"PICODICT"
+VERSION = 1
+KEY_LEN = 8
+
+
+HEX_DIGITS = set(b"0123456789abcdefABCDEF")
+
+
+def parse_keys(data):
+    # Same rule as iclass_elite_dict_parse_line: lines end at LF with an optional CR before it,
+    # comments and anything that isn't exactly 16 hex digits are skipped
+    keys = []
+    for line in data.split(b"\n"):
+        line = line.rstrip(b"\r\n")
+        if line.startswith(b"#") or len(line) != KEY_LEN * 2 or not set(line) <= HEX_DIGITS:
+            continue
+        keys.append(bytes.fromhex(line.decode("ascii")))
+    return keys
+
+
+def compile_dict(src, dst):
+    # Binary, so no newline translation the app wouldn't do either
+    with open(src, "rb") as f:
+        keys = parse_keys(f.read())
+    with open(dst, "wb") as f:
+        f.write(struct.pack("<8sHHI", MAGIC, VERSION, KEY_LEN, len(keys)))
+        f.write(b"".join(keys))
+    return len(keys)
+
+
+def main(argv):
+    if len(argv) != 3:
+        print("usage: %s dict.txt dict.bin" % argv[0], file=sys.stderr)
+        return 1
+    compile_dict(argv[1], argv[2])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
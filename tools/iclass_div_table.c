@@ -0,0 +1,243 @@
+// Host-side precomputation of standard KDF div keys for known cards, so the app can look them up
+// instead of running DES for every dictionary key when the card is presented again.
+//
+// Build from the repository root:
+//   cc -O3 -Ilib/loclass -o iclass_div_table tools/iclass_div_table.c lib/loclass/*.c
+//
+// Usage: iclass_div_table [-d dict] [-o dir] <csn|.picopass>...
+//
+// CSNs are 16 hex digits or the Block 0 of a saved .picopass file. One <CSN>.bin is written per
+// CSN, copy them to apps_data/picopass/div on the SD card. Every key of the dictionary (.txt or
+// compiled .bin, files/iclass_standard_dict.txt by default) gets its DES schedule set up once
+// and is then diversified against each CSN.
+//
+// Layout, little endian, read by helpers/iclass_div_table.c:
+//   char     magic[8]    "PICODIVT"
+//   uint16_t version     1
+//   uint16_t key_len     8
+//   uint8_t  csn[8]
+//   uint32_t total_keys
+//   struct { uint8_t key[8]; uint8_t div_key[8]; } entries[total_keys], sorted by key
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "optimized_des.h"
+#include "optimized_ikeys.h"
+
+#define ICLASS_DIV_TABLE_MAGIC    "PICODIVT"
+#define ICLASS_DIV_TABLE_VERSION  1
+#define ICLASS_DIV_TABLE_KEY_LEN  8
+// What the app is willing to load, see helpers/iclass_div_table.h
+#define ICLASS_DIV_TABLE_MAX_KEYS 512
+#define ICLASS_DIV_TABLE_DICT_MAGIC  "PICODICT"
+#define ICLASS_DIV_TABLE_DICT_HEADER 16
+
+static bool iclass_div_table_parse_hex(const char* hex, uint8_t* out, size_t len) {
+    if(strlen(hex) != len * 2) return false;
+    for(size_t i = 0; i < len; i++) {
+        unsigned int byte;
+        if(sscanf(hex + i * 2, "%2x", &byte) != 1) return false;
+        out[i] = byte;
+    }
+    return true;
+}
+
+static int iclass_div_table_compare_keys(const void* a, const void* b) {
+    return memcmp(a, b, ICLASS_DIV_TABLE_KEY_LEN);
+}
+
+// Compiled .bin dictionaries, or the same text rules as tools/iclass_dict_compile.py. Keys come
+// back sorted without duplicates, the order the app binary searches them in.
+static uint8_t* iclass_div_table_load_dict(const char* path, size_t* count) {
+    FILE* file = fopen(path, "rb");
+    if(!file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    uint8_t* keys = NULL;
+    size_t total = 0;
+    uint8_t header[ICLASS_DIV_TABLE_DICT_HEADER];
+    if(fread(header, 1, sizeof(header), file) == sizeof(header) &&
+       memcmp(header, ICLASS_DIV_TABLE_DICT_MAGIC, 8) == 0) {
+        uint32_t header_total = header[12] | header[13] << 8 | header[14] << 16 |
+                                (uint32_t)header[15] << 24;
+        keys = malloc((size_t)header_total * ICLASS_DIV_TABLE_KEY_LEN + 1);
+        total = fread(keys, ICLASS_DIV_TABLE_KEY_LEN, header_total, file);
+    } else {
+        rewind(file);
+        size_t capacity = 256;
+        keys = malloc(capacity * ICLASS_DIV_TABLE_KEY_LEN);
+        char line[64];
+        while(fgets(line, sizeof(line), file)) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if(line[0] == '#') continue;
+            if(total == capacity) {
+                capacity *= 2;
+                keys = realloc(keys, capacity * ICLASS_DIV_TABLE_KEY_LEN);
+            }
+            if(iclass_div_table_parse_hex(
+                   line, keys + total * ICLASS_DIV_TABLE_KEY_LEN, ICLASS_DIV_TABLE_KEY_LEN)) {
+                total++;
+            }
+        }
+    }
+    fclose(file);
+
+    qsort(keys, total, ICLASS_DIV_TABLE_KEY_LEN, iclass_div_table_compare_keys);
+    size_t unique = 0;
+    for(size_t i = 0; i < total; i++) {
+        uint8_t* key = keys + i * ICLASS_DIV_TABLE_KEY_LEN;
+        if(unique > 0 && iclass_div_table_compare_keys(
+                             key, keys + (unique - 1) * ICLASS_DIV_TABLE_KEY_LEN) == 0) {
+            continue;
+        }
+        memmove(keys + unique * ICLASS_DIV_TABLE_KEY_LEN, key, ICLASS_DIV_TABLE_KEY_LEN);
+        unique++;
+    }
+
+    *count = unique;
+    return keys;
+}
+
+// A CSN in hex, or the "Block 0: xx xx ..." line of a saved card
+static bool iclass_div_table_parse_csn(const char* arg, uint8_t* csn) {
+    if(iclass_div_table_parse_hex(arg, csn, ICLASS_DIV_TABLE_KEY_LEN)) return true;
+
+    FILE* file = fopen(arg, "r");
+    if(!file) {
+        fprintf(stderr, "%s: %s\n", arg, strerror(errno));
+        return false;
+    }
+    bool parsed = false;
+    char line[128];
+    while(!parsed && fgets(line, sizeof(line), file)) {
+        unsigned int bytes[ICLASS_DIV_TABLE_KEY_LEN];
+        parsed = sscanf(
+                     line,
+                     "Block 0: %x %x %x %x %x %x %x %x",
+                     &bytes[0],
+                     &bytes[1],
+                     &bytes[2],
+                     &bytes[3],
+                     &bytes[4],
+                     &bytes[5],
+                     &bytes[6],
+                     &bytes[7]) == ICLASS_DIV_TABLE_KEY_LEN;
+        for(size_t i = 0; parsed && i < ICLASS_DIV_TABLE_KEY_LEN; i++) {
+            csn[i] = bytes[i];
+        }
+    }
+    fclose(file);
+    if(!parsed) fprintf(stderr, "%s: no CSN\n", arg);
+    return parsed;
+}
+
+static bool iclass_div_table_write(
+    const char* dir,
+    const uint8_t* csn,
+    const uint8_t* keys,
+    const LoclassDesSchedule_t* scheds,
+    size_t count) {
+    char path[4096];
+    int len = snprintf(path, sizeof(path), "%s/", dir);
+    for(size_t i = 0; i < ICLASS_DIV_TABLE_KEY_LEN; i++) {
+        len += snprintf(path + len, sizeof(path) - len, "%02X", csn[i]);
+    }
+    snprintf(path + len, sizeof(path) - len, ".bin");
+
+    FILE* file = fopen(path, "wb");
+    if(!file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    uint8_t header[8 + 2 + 2 + ICLASS_DIV_TABLE_KEY_LEN + 4];
+    memcpy(header, ICLASS_DIV_TABLE_MAGIC, 8);
+    header[8] = ICLASS_DIV_TABLE_VERSION;
+    header[9] = 0;
+    header[10] = ICLASS_DIV_TABLE_KEY_LEN;
+    header[11] = 0;
+    memcpy(header + 12, csn, ICLASS_DIV_TABLE_KEY_LEN);
+    for(size_t i = 0; i < 4; i++) {
+        header[20 + i] = count >> (8 * i);
+    }
+    bool written = fwrite(header, sizeof(header), 1, file) == 1;
+
+    for(size_t i = 0; written && i < count; i++) {
+        uint8_t entry[ICLASS_DIV_TABLE_KEY_LEN * 2];
+        memcpy(entry, keys + i * ICLASS_DIV_TABLE_KEY_LEN, ICLASS_DIV_TABLE_KEY_LEN);
+        loclass_diversifyKey_sched(csn, &scheds[i], entry + ICLASS_DIV_TABLE_KEY_LEN);
+        written = fwrite(entry, sizeof(entry), 1, file) == 1;
+    }
+    written = fclose(file) == 0 && written;
+
+    if(written) {
+        printf("%s: %zu keys\n", path, count);
+    } else {
+        fprintf(stderr, "%s: write failed\n", path);
+    }
+    return written;
+}
+
+static void iclass_div_table_usage(const char* name) {
+    fprintf(stderr, "usage: %s [-d dict] [-o dir] <csn|.picopass>...\n", name);
+}
+
+int main(int argc, char* argv[]) {
+    const char* dict_path = "files/iclass_standard_dict.txt";
+    const char* dir = ".";
+    int opt;
+    while((opt = getopt(argc, argv, "d:o:")) != -1) {
+        if(opt == 'd') {
+            dict_path = optarg;
+        } else if(opt == 'o') {
+            dir = optarg;
+        } else {
+            iclass_div_table_usage(argv[0]);
+            return 1;
+        }
+    }
+    if(optind == argc) {
+        iclass_div_table_usage(argv[0]);
+        return 1;
+    }
+
+    size_t count = 0;
+    uint8_t* keys = iclass_div_table_load_dict(dict_path, &count);
+    if(!keys) return 1;
+    if(count == 0 || count > ICLASS_DIV_TABLE_MAX_KEYS) {
+        fprintf(
+            stderr,
+            "%s: %zu keys, the app takes 1 to %d\n",
+            dict_path,
+            count,
+            ICLASS_DIV_TABLE_MAX_KEYS);
+        free(keys);
+        return 1;
+    }
+
+    LoclassDesSchedule_t* scheds = malloc(count * sizeof(LoclassDesSchedule_t));
+    for(size_t i = 0; i < count; i++) {
+        loclass_des_setkey_enc(&scheds[i], keys + i * ICLASS_DIV_TABLE_KEY_LEN);
+    }
+
+    int failed = 0;
+    for(int i = optind; i < argc; i++) {
+        uint8_t csn[ICLASS_DIV_TABLE_KEY_LEN];
+        if(!iclass_div_table_parse_csn(argv[i], csn) ||
+           !iclass_div_table_write(dir, csn, keys, scheds, count)) {
+            failed++;
+        }
+    }
+
+    free(scheds);
+    free(keys);
+    return failed ? 1 : 0;
+}
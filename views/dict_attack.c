@@ -26,6 +26,9 @@ typedef struct {
     uint16_t dict_keys_current;
     bool is_key_attack;
     uint8_t key_attack_current_sector;
+    uint16_t keys_per_s;
+    uint32_t eta_s;
+    uint8_t rf_percent;
 } DictAttackViewModel;
 
 static void dict_attack_draw_callback(Canvas* canvas, void* model) {
@@ -77,12 +80,23 @@ static void dict_attack_draw_callback(Canvas* canvas, void* model) {
         canvas_set_font(canvas, FontSecondary);
         snprintf(draw_str, sizeof(draw_str), "Keys found: %d/%d", m->keys_found, m->keys_total);
         canvas_draw_str_aligned(canvas, 0, 33, AlignLeft, AlignTop, draw_str);
-        snprintf(
-            draw_str,
-            sizeof(draw_str),
-            "Application Area Read: %d/%d",
-            m->sectors_read,
-            m->sectors_total);
+        if(m->keys_per_s > 0) {
+            snprintf(
+                draw_str,
+                sizeof(draw_str),
+                "%u k/s ETA %lu:%02lu RF %u%%",
+                m->keys_per_s,
+                m->eta_s / 60,
+                m->eta_s % 60,
+                m->rf_percent);
+        } else {
+            snprintf(
+                draw_str,
+                sizeof(draw_str),
+                "Application Area Read: %d/%d",
+                m->sectors_read,
+                m->sectors_total);
+        }
         canvas_draw_str_aligned(canvas, 0, 43, AlignLeft, AlignTop, draw_str);
         elements_button_center(canvas, "Skip");
     }
@@ -141,6 +155,9 @@ void dict_attack_reset(DictAttack* dict_attack) {
             model->dict_keys_total = 0;
             model->dict_keys_current = 0;
             model->is_key_attack = false;
+            model->keys_per_s = 0;
+            model->eta_s = 0;
+            model->rf_percent = 0;
             furi_string_reset(model->header);
         },
         false);
@@ -302,3 +319,20 @@ void dict_attack_inc_key_attack_current_sector(DictAttack* dict_attack) {
         },
         true);
 }
+
+void dict_attack_set_speed(
+    DictAttack* dict_attack,
+    uint16_t keys_per_s,
+    uint32_t eta_s,
+    uint8_t rf_percent) {
+    furi_assert(dict_attack);
+    with_view_model(
+        dict_attack->view,
+        DictAttackViewModel * model,
+        {
+            model->keys_per_s = keys_per_s;
+            model->eta_s = eta_s;
+            model->rf_percent = rf_percent;
+        },
+        true);
+}
@@ -43,3 +43,12 @@ void dict_attack_inc_current_dict_key(DictAttack* dict_attack, uint16_t keys_tri
 void dict_attack_set_key_attack(DictAttack* dict_attack, bool is_key_attack, uint8_t sector);
 
 void dict_attack_inc_key_attack_current_sector(DictAttack* dict_attack);
+
+/**
+ * Replaces the application area line with the attack speed, keys_per_s 0 puts it back
+ */
+void dict_attack_set_speed(
+    DictAttack* dict_attack,
+    uint16_t keys_per_s,
+    uint32_t eta_s,
+    uint8_t rf_percent);
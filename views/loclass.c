@@ -12,8 +12,11 @@ struct Loclass {
 
 typedef struct {
     FuriString* header;
-    uint8_t num_macs;
+    uint32_t num_macs;
+    uint32_t macs_to_collect;
     FuriString* subheader;
+    uint32_t queued;
+    uint32_t dropped;
 } LoclassViewModel;
 
 static void loclass_draw_callback(Canvas* canvas, void* model) {
@@ -24,24 +27,35 @@ static void loclass_draw_callback(Canvas* canvas, void* model) {
     canvas_draw_str_aligned(canvas, 64, 0, AlignCenter, AlignTop, furi_string_get_cstr(m->header));
     canvas_set_font(canvas, FontSecondary);
 
-    if(m->num_macs == 255) {
+    if(m->num_macs == LOCLASS_NUM_MACS_NONE) {
         return;
     }
 
-    float progress = m->num_macs == 0 ? 0 :
-                                        (float)(m->num_macs) / (float)(LOCLASS_MACS_TO_COLLECT);
+    if(m->macs_to_collect) {
+        float progress = (float)(m->num_macs) / (float)(m->macs_to_collect);
 
-    if(progress > 1.0) {
-        progress = 1.0;
-    }
+        if(progress > 1.0) {
+            progress = 1.0;
+        }
 
-    snprintf(draw_str, sizeof(draw_str), "%d/%d", m->num_macs, LOCLASS_MACS_TO_COLLECT);
+        snprintf(draw_str, sizeof(draw_str), "%lu/%lu", m->num_macs, m->macs_to_collect);
 
-    elements_progress_bar_with_text(canvas, 0, 20, 128, progress, draw_str);
+        elements_progress_bar_with_text(canvas, 0, 20, 128, progress, draw_str);
+    } else {
+        // Open ended plan, runs until skipped
+        snprintf(draw_str, sizeof(draw_str), "%lu MACs", m->num_macs);
+        canvas_draw_str_aligned(canvas, 64, 26, AlignCenter, AlignCenter, draw_str);
+    }
 
     canvas_draw_str_aligned(
         canvas, 64, 45, AlignCenter, AlignBottom, furi_string_get_cstr(m->subheader));
 
+    // Records still waiting for the SD card, and records that never made it there
+    snprintf(draw_str, sizeof(draw_str), "Q:%lu", m->queued);
+    canvas_draw_str_aligned(canvas, 0, 64, AlignLeft, AlignBottom, draw_str);
+    snprintf(draw_str, sizeof(draw_str), "Drop:%lu", m->dropped);
+    canvas_draw_str_aligned(canvas, 128, 64, AlignRight, AlignBottom, draw_str);
+
     elements_button_center(canvas, "Skip");
 }
 
@@ -65,7 +79,13 @@ Loclass* loclass_alloc() {
     view_set_input_callback(loclass->view, loclass_input_callback);
     view_set_context(loclass->view, loclass);
     with_view_model(
-        loclass->view, LoclassViewModel * model, { model->header = furi_string_alloc(); }, false);
+        loclass->view,
+        LoclassViewModel * model,
+        {
+            model->header = furi_string_alloc();
+            model->macs_to_collect = LOCLASS_MACS_TO_COLLECT;
+        },
+        false);
     with_view_model(
         loclass->view,
         LoclassViewModel * model,
@@ -91,6 +111,9 @@ void loclass_reset(Loclass* loclass) {
         LoclassViewModel * model,
         {
             model->num_macs = 0;
+            model->macs_to_collect = LOCLASS_MACS_TO_COLLECT;
+            model->queued = 0;
+            model->dropped = 0;
             furi_string_reset(model->header);
             furi_string_reset(model->subheader);
         },
@@ -128,8 +151,32 @@ void loclass_set_subheader(Loclass* loclass, const char* subheader) {
         true);
 }
 
-void loclass_set_num_macs(Loclass* loclass, uint16_t num_macs) {
+void loclass_set_num_macs(Loclass* loclass, uint32_t num_macs) {
     furi_assert(loclass);
     with_view_model(
         loclass->view, LoclassViewModel * model, { model->num_macs = num_macs; }, true);
 }
+
+void loclass_set_writer_stats(Loclass* loclass, uint32_t queued, uint32_t dropped) {
+    furi_assert(loclass);
+    // Polled from the scene tick, only redraw when something changed
+    bool changed = false;
+    with_view_model(
+        loclass->view,
+        LoclassViewModel * model,
+        {
+            changed = model->queued != queued || model->dropped != dropped;
+            model->queued = queued;
+            model->dropped = dropped;
+        },
+        changed);
+}
+
+void loclass_set_macs_to_collect(Loclass* loclass, uint32_t macs_to_collect) {
+    furi_assert(loclass);
+    with_view_model(
+        loclass->view,
+        LoclassViewModel * model,
+        { model->macs_to_collect = macs_to_collect; },
+        true);
+}
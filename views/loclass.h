@@ -3,6 +3,9 @@
 #include <gui/view.h>
 #include <gui/modules/widget.h>
 
+// Hides the progress, for errors
+#define LOCLASS_NUM_MACS_NONE UINT32_MAX
+
 typedef struct Loclass Loclass;
 
 typedef void (*LoclassCallback)(void* context);
@@ -21,4 +24,11 @@ void loclass_set_header(Loclass* loclass, const char* header);
 
 void loclass_set_subheader(Loclass* loclass, const char* subheader);
 
-void loclass_set_num_macs(Loclass* loclass, uint16_t num_macs);
+void loclass_set_num_macs(Loclass* loclass, uint32_t num_macs);
+
+/**
+ * Total of the collection plan, 0 if it runs until skipped
+ */
+void loclass_set_macs_to_collect(Loclass* loclass, uint32_t macs_to_collect);
+
+void loclass_set_writer_stats(Loclass* loclass, uint32_t queued, uint32_t dropped);